@@ -3,6 +3,10 @@
 */
 
 #include <Groundtrack.h>
+#include <ThreadPool.h>
+#include <TleCatalog.h>
+#include <cstring>
+#include <iterator>
 
 int main(int argc, char **argv)
 {
@@ -11,11 +15,12 @@ int main(int argc, char **argv)
     std::string tle_filename;
     int dt = 60; // delta time between groundtrack points
 	int c;
-    char *s_opt = 0, *e_opt = 0, *t_opt = 0, *f_opt = 0;
+    char *s_opt = 0, *e_opt = 0, *t_opt = 0, *f_opt = 0, *o_opt = 0;
     char *zero_opt = 0, *one_opt = 0, *two_opt = 0;
     bool verbose = false;
+    Groundtrack::Format format = Groundtrack::Format::GeoJSON;
 
-    std::string options("0:1:2:3:s:e:t:f:v");
+    std::string options("0:1:2:3:s:e:t:f:o:v");
     while ( (c = getopt(argc, argv, options.c_str())) != -1) {
         switch (c) {
         case '0':
@@ -63,6 +68,21 @@ int main(int argc, char **argv)
             f_opt = optarg;
             tle_filename = f_opt;
             break;
+        case 'o':
+            o_opt = optarg;
+            if (strcmp(o_opt, "geojson") == 0)
+                format = Groundtrack::Format::GeoJSON;
+            else if (strcmp(o_opt, "columnar") == 0)
+                format = Groundtrack::Format::Columnar;
+            else if (strcmp(o_opt, "columnar32") == 0)
+                format = Groundtrack::Format::ColumnarFloat;
+            else if (strcmp(o_opt, "arrow") == 0)
+                format = Groundtrack::Format::Arrow;
+            else {
+                std::cerr << "Unknown output format: " << o_opt << "\n";
+                exit(1);
+            }
+            break;
         case 'v':
             verbose = true;
         case '?':
@@ -80,51 +100,47 @@ int main(int argc, char **argv)
     }
 
     // Read TLEs from the input file or piped into stdin.
-    std::istream* tle_source;
-    std::ifstream tle_file;
-    tle_source = &std::cin;
-    if (!tle_filename.empty()) {
-        tle_file.open(tle_filename.c_str());
-        tle_source = &tle_file;
-    }
-    std::string line1, line2;
+    ThreadPool pool;
+    TleCatalog catalog;
     std::vector<Tle> tles;
 
     if (verbose) std::cerr << "Generating track from " << start_time.ToString() <<
         " to " << end_time.ToString() << ".\nReading TLEs.\n";
-    
-    while(!safeGetline(*tle_source, line1).eof()) 
-    {
-        safeGetline(*tle_source, line2);
-        if (line1.empty() || line2.empty())
-        {
-            continue;
-        }
 
-        if (line1.length() != 69 || line2.length() != 69)
-        {
-            continue;
+    try {
+        if (!tle_filename.empty()) {
+            catalog.Load(tle_filename, pool);
         }
+        else {
+            std::string input((std::istreambuf_iterator<char>(std::cin)),
+                              std::istreambuf_iterator<char>());
+            catalog.Parse(input.data(), input.length(), pool);
+        }
+    } catch(TleException& e)
+    {
+        if (verbose) std::cerr << "TleException: " << e.what() << "\n";
+    }
 
-        // line1 = rtrim(line1);
-        // line2 = rtrim(line2);
-        try {
-            Tle tle(line1, line2);
-            if (tle.Epoch() >= start_time.AddDays(-1.0 * Groundtrack::max_prop_days) && 
-                tle.Epoch() <= end_time.AddDays(Groundtrack::max_prop_days)) 
-            {
-                tles.push_back(tle);
-            }
-        } catch(TleException& e) 
+    if (verbose) {
+        for (size_t i = 0; i < catalog.Errors().size(); ++i)
+            std::cerr << "TleException: line " << catalog.Errors()[i].line <<
+                ": " << catalog.Errors()[i].message << "\n";
+    }
+
+    for (size_t i = 0; i < catalog.Size(); ++i)
+    {
+        const Tle& tle = catalog.Tles()[i];
+        if (tle.Epoch() >= start_time.AddDays(-1.0 * Groundtrack::max_prop_days) && 
+            tle.Epoch() <= end_time.AddDays(Groundtrack::max_prop_days)) 
         {
-            if (verbose) std::cerr << "TleException: " << e.what() << "\n";
-            continue;   
+            tles.push_back(tle);
         }
     }
     if (verbose) std::cerr << "Done reading TLEs.\nGenerating groundtrack.\n";
 
     Groundtrack gt(start_time, end_time, dt, std::move(tles));
-    std::cout << gt.Generate(Groundtrack::Format::GeoJSON) << std::endl;
+    gt.Generate(format, std::cout, pool);
+    if (format == Groundtrack::Format::GeoJSON) std::cout << std::endl;
 
     if (verbose) std::cerr << "Done generating groundtrack. Exiting.\n";
 
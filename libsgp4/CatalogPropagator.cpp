@@ -0,0 +1,298 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "CatalogPropagator.h"
+
+#include "OrbitalElements.h"
+#include "SGP4.h"
+#include "SatelliteException.h"
+
+#include <algorithm>
+
+/*
+ * relative propagation cost of near and deep space satellites, used to
+ * size the chunks
+ */
+static const size_t kNearSpaceCost = 1;
+static const size_t kDeepSpaceCost = 16;
+/*
+ * chunks per thread and the smallest chunk worth scheduling
+ */
+static const size_t kChunksPerThread = 8;
+static const size_t kMinimumChunkCost = 256;
+
+/**
+ * Initialise every tle, using the threads of the pool
+ * @param[in] tles the catalog
+ * @param[in] pool the threads to propagate with, which must outlive
+ * this object
+ */
+CatalogPropagator::CatalogPropagator(
+        const std::vector<Tle>& tles,
+        ThreadPool& pool)
+    : pool_(pool),
+      size_(tles.size())
+{
+    std::vector<size_t> cost(tles.size());
+    size_t total = 0;
+
+    for (size_t i = 0; i < tles.size(); i++)
+    {
+        cost[i] = SGP4::UsesDeepSpace(OrbitalElements(tles[i]))
+            ? kDeepSpaceCost : kNearSpaceCost;
+        total += cost[i];
+    }
+
+    size_t target = total / (pool_.Size() * kChunksPerThread);
+    if (target < kMinimumChunkCost)
+    {
+        target = kMinimumChunkCost;
+    }
+
+    /*
+     * cut into runs of neighbouring satellites of about the target cost
+     */
+    std::vector<size_t> first(1, 0);
+    size_t chunk_cost = 0;
+    for (size_t i = 0; i < tles.size(); i++)
+    {
+        chunk_cost += cost[i];
+        if (chunk_cost >= target && i + 1 < tles.size())
+        {
+            first.push_back(i + 1);
+            chunk_cost = 0;
+        }
+    }
+    first.push_back(tles.size());
+
+    chunks_.resize(first.size() - 1);
+
+    pool_.ParallelFor(chunks_.size(), [&](size_t c)
+    {
+        Chunk& chunk = chunks_[c];
+        chunk.first = first[c];
+        chunk.count = first[c + 1] - first[c];
+
+        for (size_t i = first[c]; i < first[c + 1]; i++)
+        {
+            try
+            {
+                SGP4 model(tles[i]);
+                if (model.UsesDeepSpace())
+                {
+                    model.SetIntegratorCheckpoints(
+                            SGP4::kDefaultIntegratorCheckpoints);
+                }
+                chunk.batch.Add(model);
+                chunk.members.push_back(i);
+            }
+            catch (SatelliteException&)
+            {
+                /*
+                 * never valid, left out of the batch
+                 */
+            }
+        }
+    });
+}
+
+/**
+ * @param[in] i the catalog index of a satellite
+ * @returns whether its tle could be initialised
+ */
+bool CatalogPropagator::IsValid(const size_t i) const
+{
+    const Chunk* chunk;
+    size_t slot;
+    return Find(i, chunk, slot);
+}
+
+/**
+ * Propagate one satellite to a time of its own, without throwing, for
+ * callers refining the results of the catalog. Deep space satellites
+ * start from the integrator checkpoints the catalog keeps for them
+ * @param[in] i the catalog index of the satellite
+ * @param[in] tsince minutes since the epoch of the satellite
+ * @param[out] eci the position and velocity, zero unless the result is
+ * SGP4::kOk or SGP4::kDecayed
+ * @returns the outcome, SGP4::kInvalidElements where the tle could not
+ * be initialised
+ */
+SGP4::Status CatalogPropagator::TryFindPosition(
+        const size_t i,
+        const double tsince,
+        Eci& eci) const
+{
+    const Chunk* chunk;
+    size_t slot;
+    if (!Find(i, chunk, slot))
+    {
+        eci = Eci(eci.GetDateTime(), Vector());
+        return SGP4::kInvalidElements;
+    }
+    return chunk->batch.TryFindPosition(slot, tsince, eci);
+}
+
+/*
+ * The chunk holding a satellite and its slot within the batch
+ * @returns false if the tle could not be initialised
+ */
+bool CatalogPropagator::Find(
+        const size_t i,
+        const Chunk*& chunk,
+        size_t& slot) const
+{
+    /*
+     * the chunk covering i, then its place among the members
+     */
+    size_t lo = 0;
+    size_t hi = chunks_.size();
+    while (hi - lo > 1)
+    {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (chunks_[mid].first <= i)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    chunk = &chunks_[lo];
+    const std::vector<size_t>::const_iterator member = std::lower_bound(
+            chunk->members.begin(), chunk->members.end(), i);
+    if (member == chunk->members.end() || *member != i)
+    {
+        return false;
+    }
+    slot = static_cast<size_t>(member - chunk->members.begin());
+    return true;
+}
+
+/**
+ * Propagate the catalog to one time
+ * @param[in] dt the time to propagate to
+ * @param[out] position 3 * Size() values, x y z in kilometers
+ * @param[out] velocity 3 * Size() values, x y z in kilometers per second,
+ * or NULL to compute positions only
+ * @param[out] status Size() values, the outcome for each satellite,
+ * SGP4::kInvalidElements where the tle could not be initialised.
+ * Position and velocity are zero unless it is SGP4::kOk or
+ * SGP4::kDecayed
+ */
+void CatalogPropagator::Propagate(
+        const DateTime& dt,
+        double* position,
+        double* velocity,
+        SGP4::Status* status) const
+{
+    Propagate(dt, TimeSpan(0), 1, position, velocity, status);
+}
+
+/**
+ * Propagate the catalog to a series of times. The results of satellite i
+ * at step k are at index i * steps + k.
+ * @param[in] start the first time
+ * @param[in] step the time between steps
+ * @param[in] steps the number of times
+ * @param[out] position 3 * Size() * steps values, x y z in kilometers
+ * @param[out] velocity 3 * Size() * steps values, x y z in kilometers
+ * per second, or NULL to compute positions only
+ * @param[out] status Size() * steps values, the outcome for each result,
+ * SGP4::kInvalidElements where the tle could not be initialised.
+ * Position and velocity are zero unless it is SGP4::kOk or
+ * SGP4::kDecayed
+ */
+void CatalogPropagator::Propagate(
+        const DateTime& start,
+        const TimeSpan& step,
+        const size_t steps,
+        double* position,
+        double* velocity,
+        SGP4::Status* status) const
+{
+    pool_.ParallelFor(chunks_.size(), [&](size_t c)
+    {
+        const Chunk& chunk = chunks_[c];
+        const size_t count = chunk.members.size();
+
+        if (count < chunk.count)
+        {
+            Invalidate(chunk, steps, position, velocity, status);
+        }
+        if (count == 0)
+        {
+            return;
+        }
+
+        std::vector<double> pos(3 * count);
+        std::vector<double> vel(velocity ? 3 * count : 0);
+        std::vector<SGP4::Status> results(count);
+
+        for (size_t k = 0; k < steps; k++)
+        {
+            const DateTime dt(start.Ticks()
+                    + step.Ticks() * static_cast<long long>(k));
+
+            chunk.batch.FindPositions(dt, &pos[0],
+                    velocity ? &vel[0] : NULL, &results[0]);
+
+            for (size_t j = 0; j < count; j++)
+            {
+                const size_t i = chunk.members[j] * steps + k;
+                position[3 * i] = pos[3 * j];
+                position[3 * i + 1] = pos[3 * j + 1];
+                position[3 * i + 2] = pos[3 * j + 2];
+                if (velocity)
+                {
+                    velocity[3 * i] = vel[3 * j];
+                    velocity[3 * i + 1] = vel[3 * j + 1];
+                    velocity[3 * i + 2] = vel[3 * j + 2];
+                }
+                status[i] = results[j];
+            }
+        }
+    });
+}
+
+/*
+ * Zero every result of a chunk and mark it as having invalid elements
+ */
+void CatalogPropagator::Invalidate(
+        const Chunk& chunk,
+        const size_t steps,
+        double* position,
+        double* velocity,
+        SGP4::Status* status) const
+{
+    for (size_t i = chunk.first * steps;
+            i < (chunk.first + chunk.count) * steps; i++)
+    {
+        position[3 * i] = 0.0;
+        position[3 * i + 1] = 0.0;
+        position[3 * i + 2] = 0.0;
+        if (velocity)
+        {
+            velocity[3 * i] = 0.0;
+            velocity[3 * i + 1] = 0.0;
+            velocity[3 * i + 2] = 0.0;
+        }
+        status[i] = SGP4::kInvalidElements;
+    }
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CATALOGPROPAGATOR_H_
+#define CATALOGPROPAGATOR_H_
+
+#include "SGP4Batch.h"
+#include "ThreadPool.h"
+#include "Tle.h"
+#include "DateTime.h"
+#include "TimeSpan.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Propagates a whole catalog across the threads of a ThreadPool.
+ *
+ * The catalog is cut into chunks of neighbouring satellites, each held as
+ * an SGP4Batch. Chunks are sized by estimated cost rather than by count,
+ * a deep space satellite costing many near earth ones, and there are
+ * several per thread so that work stealing can even out the rest.
+ *
+ * Results are written into caller-provided buffers indexed by the
+ * position of each tle in the catalog. A satellite whose tle could not
+ * be initialised, or whose propagation fails, is reported through an
+ * SGP4::Status rather than stopping the rest of the catalog.
+ *
+ * A CatalogPropagator must only be used by one thread at a time.
+ */
+class CatalogPropagator
+{
+public:
+    CatalogPropagator(const std::vector<Tle>& tles, ThreadPool& pool);
+
+    virtual ~CatalogPropagator()
+    {
+    }
+
+    /**
+     * @returns the number of satellites in the catalog
+     */
+    size_t Size() const
+    {
+        return size_;
+    }
+
+    bool IsValid(const size_t i) const;
+    SGP4::Status TryFindPosition(
+            const size_t i,
+            const double tsince,
+            Eci& eci) const;
+
+    void Propagate(
+            const DateTime& dt,
+            double* position,
+            double* velocity,
+            SGP4::Status* status) const;
+    void Propagate(
+            const DateTime& start,
+            const TimeSpan& step,
+            const size_t steps,
+            double* position,
+            double* velocity,
+            SGP4::Status* status) const;
+
+private:
+    struct Chunk
+    {
+        /*
+         * the range of the catalog covered
+         */
+        size_t first;
+        size_t count;
+        /*
+         * the catalog indices of the satellites in the batch, in order,
+         * which leaves out those that could not be initialised
+         */
+        std::vector<size_t> members;
+        SGP4Batch batch;
+    };
+
+    bool Find(
+            const size_t i,
+            const Chunk*& chunk,
+            size_t& slot) const;
+    void Invalidate(
+            const Chunk& chunk,
+            const size_t steps,
+            double* position,
+            double* velocity,
+            SGP4::Status* status) const;
+
+    ThreadPool& pool_;
+    size_t size_;
+    std::vector<Chunk> chunks_;
+};
+
+#endif
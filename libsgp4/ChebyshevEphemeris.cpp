@@ -0,0 +1,383 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ChebyshevEphemeris.h"
+
+#include "Globals.h"
+#include "SatelliteException.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    /*
+     * the first segment length tried, in minutes
+     */
+    static const double kInitialSegment = 60.0;
+    /*
+     * the shortest segment allowed, in minutes
+     */
+    static const double kMinimumSegment = 0.1;
+
+    /*
+     * the cosines used in fitting a segment, the same for every segment
+     */
+    struct Cosines
+    {
+        static const size_t kCount = ChebyshevEphemeris::kDegree + 1;
+
+        Cosines()
+        {
+            for (size_t j = 0; j < kCount; j++)
+            {
+                for (size_t k = 0; k < kCount; k++)
+                {
+                    terms[j][k] = cos(kPI * static_cast<double>(j)
+                            * (static_cast<double>(k) + 0.5)
+                            / static_cast<double>(kCount));
+                }
+            }
+            for (size_t k = 0; k <= kCount; k++)
+            {
+                extrema[k] = cos(kPI * static_cast<double>(k)
+                        / static_cast<double>(kCount));
+            }
+        }
+
+        /*
+         * the term of order j at node k, cos(pi j (k + 1/2) / n). The
+         * nodes themselves are the terms of order 1
+         */
+        double terms[kCount][kCount];
+        /*
+         * the extrema of the term of order n, cos(pi k / n)
+         */
+        double extrema[kCount + 1];
+    };
+
+    /**
+     * Evaluate the Chebyshev series of the first few of six coordinates by
+     * Clenshaw's recurrence, running the recurrences side by side
+     * @param[in] coefficients six coefficients, one per coordinate, for
+     * each order in turn
+     * @param[in] count the number of coefficients per coordinate
+     * @param[in] x the point, within [-1, 1]
+     * @param[in] coordinates the number of coordinates to evaluate, 3 for
+     * the position only or 6 for position and velocity
+     * @param[out] values the coordinates
+     */
+    void Clenshaw(
+            const double* coefficients,
+            const size_t count,
+            const double x,
+            const size_t coordinates,
+            double* values)
+    {
+        const double x2 = 2.0 * x;
+        double b1[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+        double b2[6] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+        for (size_t j = count - 1; j > 0; j--)
+        {
+            const double* a = coefficients + 6 * j;
+            for (size_t c = 0; c < coordinates; c++)
+            {
+                /*
+                 * a - b2 is ready early, leaving one multiply and add
+                 * on the path from one order to the next
+                 */
+                const double b0 = x2 * b1[c] + (a[c] - b2[c]);
+                b2[c] = b1[c];
+                b1[c] = b0;
+            }
+        }
+        for (size_t c = 0; c < coordinates; c++)
+        {
+            values[c] = x * b1[c] - b2[c] + coefficients[c];
+        }
+    }
+}
+
+/**
+ * Fit an ephemeris to a model
+ * @param[in] model the satellite
+ * @param[in] start the start of the span
+ * @param[in] end the end of the span
+ * @param[in] position_tolerance the largest difference from SGP4 allowed
+ * in each position coordinate, in kilometers
+ * @param[in] velocity_tolerance the largest difference from SGP4 allowed
+ * in each velocity coordinate, in kilometers per second
+ * @exception SatelliteException if the model fails to propagate within
+ * the span, decays within it, or cannot be fitted within the tolerances
+ */
+template <typename Gravity>
+ChebyshevEphemeris::ChebyshevEphemeris(
+        const SGP4Model<Gravity>& model,
+        const DateTime& start,
+        const DateTime& end,
+        const double position_tolerance,
+        const double velocity_tolerance)
+    : start_(start),
+      end_(end)
+{
+    if (end <= start)
+    {
+        throw SatelliteException("Ephemeris end must be after its start");
+    }
+
+    const double span = (end - start).TotalMinutes();
+    double coefficients[6 * kCoefficients];
+
+    boundaries_.push_back(0.0);
+    double length = kInitialSegment;
+    while (boundaries_.back() < span)
+    {
+        const double begin = boundaries_.back();
+        const double finish = std::min(begin + length, span);
+
+        if (Fit(model, begin, finish, position_tolerance,
+                    velocity_tolerance, coefficients))
+        {
+            boundaries_.push_back(finish);
+            coefficients_.insert(coefficients_.end(),
+                    coefficients, coefficients + 6 * kCoefficients);
+            length = 2.0 * (finish - begin);
+        }
+        else if (finish - begin > kMinimumSegment)
+        {
+            length = 0.5 * (finish - begin);
+        }
+        else
+        {
+            throw SatelliteException(
+                    "Failed to fit ephemeris within tolerance");
+        }
+    }
+}
+
+/**
+ * @param[in] dt the time, within the span of the ephemeris
+ * @returns the position and velocity of the satellite
+ * @exception SatelliteException if the time is outside the span
+ */
+Eci ChebyshevEphemeris::FindPosition(const DateTime& dt) const
+{
+    if (dt < start_ || dt > end_)
+    {
+        throw SatelliteException("Time outside of the ephemeris");
+    }
+
+    const double t = (dt - start_).TotalMinutes();
+
+    double values[6];
+    Evaluate(FindSegment(t), t, 6, values);
+
+    return Eci(dt,
+            Vector(values[0], values[1], values[2]),
+            Vector(values[3], values[4], values[5]));
+}
+
+/**
+ * Evaluate the ephemeris at a series of times. Without velocities only
+ * half of the polynomials are evaluated.
+ * @param[in] start the first time
+ * @param[in] step the time between results
+ * @param[in] count the number of results
+ * @param[out] position 3 * count values, x y z in kilometers
+ * @param[out] velocity 3 * count values, x y z in kilometers per second,
+ * or NULL to compute positions only
+ * @exception SatelliteException if a time is outside the span
+ */
+void ChebyshevEphemeris::FindPositions(
+        const DateTime& start,
+        const TimeSpan& step,
+        const size_t count,
+        double* position,
+        double* velocity) const
+{
+    const size_t coordinates = velocity ? 6 : 3;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const DateTime dt(start.Ticks()
+                + step.Ticks() * static_cast<long long>(i));
+        if (dt < start_ || dt > end_)
+        {
+            throw SatelliteException("Time outside of the ephemeris");
+        }
+
+        const double t = (dt - start_).TotalMinutes();
+
+        double values[6];
+        Evaluate(FindSegment(t), t, coordinates, values);
+
+        position[3 * i] = values[0];
+        position[3 * i + 1] = values[1];
+        position[3 * i + 2] = values[2];
+        if (velocity)
+        {
+            velocity[3 * i] = values[3];
+            velocity[3 * i + 1] = values[4];
+            velocity[3 * i + 2] = values[5];
+        }
+    }
+}
+
+/*
+ * the segment whose start is the last at or before t
+ */
+size_t ChebyshevEphemeris::FindSegment(const double t) const
+{
+    const size_t segment = static_cast<size_t>(std::upper_bound(
+                boundaries_.begin(), boundaries_.end(), t)
+            - boundaries_.begin());
+    return std::min(std::max(segment, size_t(1)), Segments()) - 1;
+}
+
+/**
+ * Fit one segment, interpolating at the Chebyshev nodes and checking the
+ * result at the extrema of the highest order term
+ * @param[in] model the satellite
+ * @param[in] begin the start of the segment, minutes from start_
+ * @param[in] end the end of the segment, minutes from start_
+ * @param[in] position_tolerance the largest position error allowed
+ * @param[in] velocity_tolerance the largest velocity error allowed
+ * @param[out] coefficients the coefficients of the segment
+ * @returns whether the fit is within the tolerances
+ */
+template <typename Gravity>
+bool ChebyshevEphemeris::Fit(
+        const SGP4Model<Gravity>& model,
+        const double begin,
+        const double end,
+        const double position_tolerance,
+        const double velocity_tolerance,
+        double* coefficients) const
+{
+    static const Cosines cosines;
+
+    /*
+     * minutes from epoch of the middle of the segment
+     */
+    const double mid = (start_ - model.elements_.Epoch()).TotalMinutes()
+        + 0.5 * (begin + end);
+    const double half = 0.5 * (end - begin);
+
+    /*
+     * the coordinates at the nodes cos(pi (k + 1/2) / n)
+     */
+    double tsince[kCoefficients + 1];
+    double position[3 * (kCoefficients + 1)];
+    double velocity[3 * (kCoefficients + 1)];
+    SGP4::Status status[kCoefficients + 1];
+    for (size_t k = 0; k < kCoefficients; k++)
+    {
+        tsince[k] = mid + half * cosines.terms[1][k];
+    }
+    model.TryFindPositions(tsince, kCoefficients, position, velocity,
+            status);
+    for (size_t k = 0; k < kCoefficients; k++)
+    {
+        if (status[k] != SGP4::kOk)
+        {
+            throw SatelliteException(
+                    "Satellite failed to propagate within the ephemeris");
+        }
+    }
+
+    for (size_t c = 0; c < 6; c++)
+    {
+        const double* values = c < 3 ? position + c : velocity + c - 3;
+        for (size_t j = 0; j < kCoefficients; j++)
+        {
+            double sum = 0.0;
+            for (size_t k = 0; k < kCoefficients; k++)
+            {
+                sum += values[3 * k] * cosines.terms[j][k];
+            }
+            coefficients[6 * j + c]
+                = (j == 0 ? 1.0 : 2.0) * sum
+                / static_cast<double>(kCoefficients);
+        }
+    }
+
+    /*
+     * the interpolation error peaks between the nodes and at the ends
+     */
+    for (size_t k = 0; k <= kCoefficients; k++)
+    {
+        tsince[k] = mid + half * cosines.extrema[k];
+    }
+    model.TryFindPositions(tsince, kCoefficients + 1, position, velocity,
+            status);
+    for (size_t k = 0; k <= kCoefficients; k++)
+    {
+        if (status[k] != SGP4::kOk)
+        {
+            throw SatelliteException(
+                    "Satellite failed to propagate within the ephemeris");
+        }
+
+        double values[6];
+        Clenshaw(coefficients, kCoefficients, cosines.extrema[k], 6,
+                values);
+
+        const double* p = position + 3 * k;
+        const double* v = velocity + 3 * k;
+        if (fabs(values[0] - p[0]) > position_tolerance
+                || fabs(values[1] - p[1]) > position_tolerance
+                || fabs(values[2] - p[2]) > position_tolerance
+                || fabs(values[3] - v[0]) > velocity_tolerance
+                || fabs(values[4] - v[1]) > velocity_tolerance
+                || fabs(values[5] - v[2]) > velocity_tolerance)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @param[in] segment the segment
+ * @param[in] t minutes from start_, within the segment
+ * @param[in] coordinates the number of coordinates, 3 or 6
+ * @param[out] values the coordinates
+ */
+void ChebyshevEphemeris::Evaluate(
+        const size_t segment,
+        const double t,
+        const size_t coordinates,
+        double* values) const
+{
+    const double begin = boundaries_[segment];
+    const double end = boundaries_[segment + 1];
+    const double x = (2.0 * t - begin - end) / (end - begin);
+
+    Clenshaw(&coefficients_[segment * 6 * kCoefficients],
+            kCoefficients, x, coordinates, values);
+}
+
+template ChebyshevEphemeris::ChebyshevEphemeris(
+        const SGP4Model<Wgs72Old>&, const DateTime&, const DateTime&,
+        const double, const double);
+template ChebyshevEphemeris::ChebyshevEphemeris(
+        const SGP4Model<Wgs72>&, const DateTime&, const DateTime&,
+        const double, const double);
+template ChebyshevEphemeris::ChebyshevEphemeris(
+        const SGP4Model<Wgs84>&, const DateTime&, const DateTime&,
+        const double, const double);
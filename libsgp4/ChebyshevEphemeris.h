@@ -0,0 +1,131 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CHEBYSHEVEPHEMERIS_H_
+#define CHEBYSHEVEPHEMERIS_H_
+
+#include "SGP4.h"
+#include "DateTime.h"
+#include "TimeSpan.h"
+#include "Eci.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Positions of one satellite over a span of time, stored as
+ * piecewise Chebyshev polynomials fitted to SGP4.
+ *
+ * The span is cut into segments and each of x, y, z and their velocities
+ * is fitted by a polynomial of fixed degree on each segment. Segment
+ * lengths adapt to the orbit, being halved until every coordinate matches
+ * SGP4 within the tolerances at the extrema of the highest order term,
+ * which include both ends of the segment, and growing again after each
+ * segment that fits.
+ *
+ * Building costs a few dozen SGP4 evaluations per segment. Afterwards a
+ * position is a binary search and a polynomial evaluation, and a
+ * satellite takes 6 * (kDegree + 1) doubles per segment.
+ */
+class ChebyshevEphemeris
+{
+public:
+    /*
+     * the degree of the polynomial on each segment
+     */
+    static const size_t kDegree = 11;
+
+    template <typename Gravity>
+    ChebyshevEphemeris(
+            const SGP4Model<Gravity>& model,
+            const DateTime& start,
+            const DateTime& end,
+            const double position_tolerance = 1.0e-3,
+            const double velocity_tolerance = 1.0e-6);
+
+    virtual ~ChebyshevEphemeris()
+    {
+    }
+
+    /**
+     * @returns the start of the span covered
+     */
+    DateTime Start() const
+    {
+        return start_;
+    }
+
+    /**
+     * @returns the end of the span covered
+     */
+    DateTime End() const
+    {
+        return end_;
+    }
+
+    /**
+     * @returns the number of segments fitted
+     */
+    size_t Segments() const
+    {
+        return boundaries_.size() - 1;
+    }
+
+    Eci FindPosition(const DateTime& dt) const;
+    void FindPositions(
+            const DateTime& start,
+            const TimeSpan& step,
+            const size_t count,
+            double* position,
+            double* velocity) const;
+
+private:
+    /*
+     * the number of coefficients of each coordinate on a segment
+     */
+    static const size_t kCoefficients = kDegree + 1;
+
+    template <typename Gravity>
+    bool Fit(
+            const SGP4Model<Gravity>& model,
+            const double begin,
+            const double end,
+            const double position_tolerance,
+            const double velocity_tolerance,
+            double* coefficients) const;
+    size_t FindSegment(const double t) const;
+    void Evaluate(
+            const size_t segment,
+            const double t,
+            const size_t coordinates,
+            double* values) const;
+
+    DateTime start_;
+    DateTime end_;
+    /*
+     * minutes from start_ to the start of each segment, followed by the
+     * end of the span
+     */
+    std::vector<double> boundaries_;
+    /*
+     * for each segment in turn, the coefficients of each order from 0 to
+     * kDegree, each as x y z then the velocities
+     */
+    std::vector<double> coefficients_;
+};
+
+#endif
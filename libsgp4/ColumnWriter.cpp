@@ -0,0 +1,550 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ColumnWriter.h"
+
+#include <cstring>
+#include <ostream>
+#include <stdint.h>
+
+namespace
+{
+    static const char kFlatMagic[8] = { 'S', 'G', 'P', '4', 'C', 'O', 'L', 'S' };
+    static const uint32_t kFlatVersion = 1;
+
+    static const char kArrowMagic[8] = { 'A', 'R', 'R', 'O', 'W', '1', 0, 0 };
+    /*
+     * the marker before each message, and the metadata version V5
+     */
+    static const uint32_t kArrowContinuation = 0xffffffff;
+    static const uint64_t kArrowVersion = 4;
+    /*
+     * codes of the MessageHeader and Type unions, and of the Precision and
+     * TimeUnit enums of the Arrow schema
+     */
+    static const uint64_t kArrowSchema = 1;
+    static const uint64_t kArrowRecordBatch = 3;
+    static const uint64_t kArrowFloatingPoint = 3;
+    static const uint64_t kArrowTimestamp = 10;
+    static const uint64_t kArrowSingle = 1;
+    static const uint64_t kArrowDouble = 2;
+    static const uint64_t kArrowMicrosecond = 2;
+    /*
+     * the alignment of each buffer in a record batch body
+     */
+    static const size_t kArrowAlignment = 64;
+
+    inline size_t Width(const ColumnSpec::Type type)
+    {
+        return type == ColumnSpec::kFloat32 ? 4 : 8;
+    }
+
+    inline void AppendUInt(
+            std::string& out,
+            const uint64_t value,
+            const size_t bytes)
+    {
+        for (size_t i = 0; i < bytes; i++)
+        {
+            out += static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+    }
+
+    inline void SetUInt(
+            std::string& out,
+            const size_t position,
+            const uint64_t value,
+            const size_t bytes)
+    {
+        for (size_t i = 0; i < bytes; i++)
+        {
+            out[position + i] = static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+    }
+
+    inline void Pad(std::string& out, const size_t alignment)
+    {
+        out.append((alignment - out.size() % alignment) % alignment, '\0');
+    }
+
+    /*
+     * A minimal flatbuffer encoder, writing front to back. Each object is
+     * written after the object referring to it, whose offset field is
+     * filled in by Link(), and every value is aligned to its size from
+     * the start of the buffer.
+     */
+
+    /*
+     * a field of a table, its vtable slot, size in bytes and value, a size
+     * of 0 for an offset to be filled in by Link()
+     */
+    struct FlatField
+    {
+        size_t slot;
+        size_t size;
+        uint64_t value;
+    };
+
+    /**
+     * Point an offset field at an object
+     */
+    inline void Link(std::string& out, const size_t field, const size_t target)
+    {
+        SetUInt(out, field, target - field, 4);
+    }
+
+    /**
+     * Append a table preceded by its vtable, the widest fields first
+     * @param[in] fields the fields
+     * @param[in] count the number of fields
+     * @param[out] positions the position of each field
+     * @returns the position of the table
+     */
+    size_t AppendTable(
+            std::string& out,
+            const FlatField* fields,
+            const size_t count,
+            size_t* positions)
+    {
+        size_t slots = 0;
+        size_t offsets[8];
+        size_t size = 4;
+        for (size_t width = 8; width > 0; width /= 2)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                const size_t field = fields[i].size ? fields[i].size : 4;
+                if (field == width)
+                {
+                    size = (size + width - 1) / width * width;
+                    offsets[i] = size;
+                    size += width;
+                }
+            }
+        }
+        for (size_t i = 0; i < count; i++)
+        {
+            slots = fields[i].slot + 1 > slots ? fields[i].slot + 1 : slots;
+        }
+
+        Pad(out, 2);
+        const size_t vtable = out.size();
+        AppendUInt(out, 4 + 2 * slots, 2);
+        AppendUInt(out, size, 2);
+        for (size_t slot = 0; slot < slots; slot++)
+        {
+            size_t offset = 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                if (fields[i].slot == slot)
+                {
+                    offset = offsets[i];
+                }
+            }
+            AppendUInt(out, offset, 2);
+        }
+
+        Pad(out, 8);
+        const size_t table = out.size();
+        out.append(size, '\0');
+        SetUInt(out, table, table - vtable, 4);
+        for (size_t i = 0; i < count; i++)
+        {
+            positions[i] = table + offsets[i];
+            if (fields[i].size)
+            {
+                SetUInt(out, positions[i], fields[i].value, fields[i].size);
+            }
+        }
+        return table;
+    }
+
+    /**
+     * Append the length of a vector, placed so that its elements follow
+     * aligned to alignment
+     * @returns the position of the vector
+     */
+    size_t AppendVector(
+            std::string& out,
+            const size_t count,
+            const size_t alignment)
+    {
+        while ((out.size() + 4) % alignment)
+        {
+            out += '\0';
+        }
+        const size_t vector = out.size();
+        AppendUInt(out, count, 4);
+        return vector;
+    }
+
+    size_t AppendString(std::string& out, const std::string& value)
+    {
+        Pad(out, 4);
+        const size_t string = out.size();
+        AppendUInt(out, value.size(), 4);
+        out += value;
+        out += '\0';
+        return string;
+    }
+
+    /**
+     * Append an Arrow Schema table and the objects it refers to
+     * @returns the position of the table
+     */
+    size_t AppendSchema(
+            std::string& out,
+            const std::vector<ColumnSpec>& columns)
+    {
+        /*
+         * endianness little, fields
+         */
+        const FlatField schema_fields[] = { { 0, 2, 0 }, { 1, 0, 0 } };
+        size_t schema_positions[2];
+        const size_t schema = AppendTable(out, schema_fields, 2,
+                schema_positions);
+
+        const size_t vector = AppendVector(out, columns.size(), 4);
+        Link(out, schema_positions[1], vector);
+        std::vector<size_t> elements(columns.size());
+        for (size_t i = 0; i < columns.size(); i++)
+        {
+            elements[i] = out.size();
+            AppendUInt(out, 0, 4);
+        }
+
+        for (size_t i = 0; i < columns.size(); i++)
+        {
+            const bool timestamp = columns[i].type == ColumnSpec::kTimestamp;
+
+            /*
+             * name, nullable, type, children
+             */
+            const FlatField field_fields[] = {
+                { 0, 0, 0 },
+                { 1, 1, 0 },
+                { 2, 1, timestamp ? kArrowTimestamp : kArrowFloatingPoint },
+                { 3, 0, 0 },
+                { 5, 0, 0 }
+            };
+            size_t field_positions[5];
+            const size_t field = AppendTable(out, field_fields, 5,
+                    field_positions);
+            Link(out, elements[i], field);
+
+            Link(out, field_positions[0], AppendString(out, columns[i].name));
+
+            if (timestamp)
+            {
+                /*
+                 * unit, timezone
+                 */
+                const FlatField type_fields[] = {
+                    { 0, 2, kArrowMicrosecond },
+                    { 1, 0, 0 }
+                };
+                size_t type_positions[2];
+                Link(out, field_positions[3], AppendTable(out, type_fields, 2,
+                            type_positions));
+                Link(out, type_positions[1], AppendString(out, "UTC"));
+            }
+            else
+            {
+                /*
+                 * precision
+                 */
+                const FlatField type_fields[] = {
+                    { 0, 2, columns[i].type == ColumnSpec::kFloat32
+                        ? kArrowSingle : kArrowDouble }
+                };
+                size_t type_positions[1];
+                Link(out, field_positions[3], AppendTable(out, type_fields, 1,
+                            type_positions));
+            }
+
+            Link(out, field_positions[4], AppendVector(out, 0, 4));
+        }
+
+        return schema;
+    }
+
+    /**
+     * Begin a flatbuffer holding an Arrow Message
+     * @param[in] header the MessageHeader union code
+     * @param[in] body the length of the message body
+     * @returns the position of the header field, to be linked
+     */
+    size_t AppendMessage(
+            std::string& out,
+            const uint64_t header,
+            const uint64_t body)
+    {
+        AppendUInt(out, 0, 4);
+
+        /*
+         * version, header type, header, body length
+         */
+        const FlatField fields[] = {
+            { 0, 2, kArrowVersion },
+            { 1, 1, header },
+            { 2, 0, 0 },
+            { 3, 8, body }
+        };
+        size_t positions[4];
+        Link(out, 0, AppendTable(out, fields, 4, positions));
+        return positions[2];
+    }
+
+    /**
+     * Frame a message flatbuffer as the Arrow format does, the
+     * continuation marker and the padded length before it
+     */
+    void Encapsulate(const std::string& metadata, std::string& out)
+    {
+        const size_t padded = (metadata.size() + 7) / 8 * 8;
+        AppendUInt(out, kArrowContinuation, 4);
+        AppendUInt(out, padded, 4);
+        out += metadata;
+        out.append(padded - metadata.size(), '\0');
+    }
+}
+
+/**
+ * Write an encoded batch
+ * @param[in] os the stream
+ * @param[in] batch a batch from EncodeBatch()
+ */
+void ColumnWriter::WriteBatch(std::ostream& os, const std::string& batch)
+{
+    Write(os, batch);
+}
+
+void ColumnWriter::Write(std::ostream& os, const std::string& bytes)
+{
+    os.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    written_ += bytes.size();
+}
+
+/**
+ * Append the values of one column, little endian, which on little endian
+ * machines is a plain copy
+ */
+void ColumnWriter::AppendColumn(
+        std::string& out,
+        const size_t column,
+        const size_t rows,
+        const void* values) const
+{
+    const size_t width = Width(columns_[column].type);
+    const char* bytes = static_cast<const char*>(values);
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    out.append(bytes, rows * width);
+#else
+    for (size_t i = 0; i < rows; i++)
+    {
+        uint64_t value = 0;
+        if (width == 4)
+        {
+            uint32_t bits;
+            memcpy(&bits, bytes + 4 * i, 4);
+            value = bits;
+        }
+        else
+        {
+            memcpy(&value, bytes + 8 * i, 8);
+        }
+        AppendUInt(out, value, width);
+    }
+#endif
+}
+
+void FlatColumnWriter::Begin(std::ostream& os)
+{
+    std::string header(kFlatMagic, sizeof(kFlatMagic));
+    AppendUInt(header, kFlatVersion, 4);
+    AppendUInt(header, columns_.size(), 4);
+    for (size_t i = 0; i < columns_.size(); i++)
+    {
+        AppendUInt(header, static_cast<uint64_t>(columns_[i].type), 4);
+        AppendUInt(header, columns_[i].name.size(), 4);
+        header += columns_[i].name;
+        Pad(header, 8);
+    }
+    Write(os, header);
+}
+
+void FlatColumnWriter::EncodeBatch(
+        const size_t rows,
+        const void* const* values,
+        std::string& batch) const
+{
+    batch.clear();
+    AppendUInt(batch, rows, 8);
+    for (size_t i = 0; i < columns_.size(); i++)
+    {
+        AppendColumn(batch, i, rows, values[i]);
+        Pad(batch, 8);
+    }
+}
+
+void FlatColumnWriter::End(std::ostream& os)
+{
+    std::string end;
+    AppendUInt(end, 0, 8);
+    Write(os, end);
+}
+
+/**
+ * Write the magic number and the schema message
+ */
+void ArrowColumnWriter::Begin(std::ostream& os)
+{
+    std::string metadata;
+    const size_t header = AppendMessage(metadata, kArrowSchema, 0);
+    Link(metadata, header, AppendSchema(metadata, columns_));
+
+    std::string bytes(kArrowMagic, sizeof(kArrowMagic));
+    Encapsulate(metadata, bytes);
+    Write(os, bytes);
+}
+
+/**
+ * Encode a record batch message, each column a validity buffer of no
+ * length, as nothing is null, and a data buffer
+ */
+void ArrowColumnWriter::EncodeBatch(
+        const size_t rows,
+        const void* const* values,
+        std::string& batch) const
+{
+    std::string body;
+    std::vector<uint64_t> offsets(columns_.size());
+    for (size_t i = 0; i < columns_.size(); i++)
+    {
+        offsets[i] = body.size();
+        AppendColumn(body, i, rows, values[i]);
+        Pad(body, kArrowAlignment);
+    }
+
+    std::string metadata;
+    const size_t header = AppendMessage(metadata, kArrowRecordBatch,
+            body.size());
+
+    /*
+     * length, nodes, buffers
+     */
+    const FlatField fields[] = { { 0, 8, rows }, { 1, 0, 0 }, { 2, 0, 0 } };
+    size_t positions[3];
+    Link(metadata, header, AppendTable(metadata, fields, 3, positions));
+
+    /*
+     * FieldNode, the length and null count of each column
+     */
+    Link(metadata, positions[1],
+            AppendVector(metadata, columns_.size(), 8));
+    for (size_t i = 0; i < columns_.size(); i++)
+    {
+        AppendUInt(metadata, rows, 8);
+        AppendUInt(metadata, 0, 8);
+    }
+
+    /*
+     * Buffer, the offset and length of each buffer in the body
+     */
+    Link(metadata, positions[2],
+            AppendVector(metadata, 2 * columns_.size(), 8));
+    for (size_t i = 0; i < columns_.size(); i++)
+    {
+        AppendUInt(metadata, offsets[i], 8);
+        AppendUInt(metadata, 0, 8);
+        AppendUInt(metadata, offsets[i], 8);
+        AppendUInt(metadata, rows * Width(columns_[i].type), 8);
+    }
+
+    batch.clear();
+    Encapsulate(metadata, batch);
+    batch += body;
+}
+
+/**
+ * Write a record batch and note where it went for the footer
+ */
+void ArrowColumnWriter::WriteBatch(
+        std::ostream& os,
+        const std::string& batch)
+{
+    uint64_t padded = 0;
+    for (size_t i = 0; i < 4; i++)
+    {
+        padded |= static_cast<uint64_t>(
+                static_cast<unsigned char>(batch[4 + i])) << (8 * i);
+    }
+
+    Block block;
+    block.offset = written_;
+    block.metadata = 8 + padded;
+    block.body = batch.size() - block.metadata;
+    blocks_.push_back(block);
+
+    Write(os, batch);
+}
+
+/**
+ * Write the end of stream marker, the footer indexing the record
+ * batches, its length and the magic number
+ */
+void ArrowColumnWriter::End(std::ostream& os)
+{
+    std::string bytes;
+    AppendUInt(bytes, kArrowContinuation, 4);
+    AppendUInt(bytes, 0, 4);
+
+    std::string footer;
+    AppendUInt(footer, 0, 4);
+
+    /*
+     * version, schema, dictionaries, record batches
+     */
+    const FlatField fields[] = {
+        { 0, 2, kArrowVersion },
+        { 1, 0, 0 },
+        { 2, 0, 0 },
+        { 3, 0, 0 }
+    };
+    size_t positions[4];
+    Link(footer, 0, AppendTable(footer, fields, 4, positions));
+    Link(footer, positions[1], AppendSchema(footer, columns_));
+    Link(footer, positions[2], AppendVector(footer, 0, 8));
+
+    /*
+     * Block, the offset, metadata length, padding and body length
+     */
+    Link(footer, positions[3], AppendVector(footer, blocks_.size(), 8));
+    for (size_t i = 0; i < blocks_.size(); i++)
+    {
+        AppendUInt(footer, blocks_[i].offset, 8);
+        AppendUInt(footer, blocks_[i].metadata, 4);
+        AppendUInt(footer, 0, 4);
+        AppendUInt(footer, blocks_[i].body, 8);
+    }
+
+    bytes += footer;
+    AppendUInt(bytes, footer.size(), 4);
+    bytes.append(kArrowMagic, 6);
+    Write(os, bytes);
+}
@@ -0,0 +1,208 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef COLUMNWRITER_H_
+#define COLUMNWRITER_H_
+
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A column of a table written by a ColumnWriter.
+ */
+struct ColumnSpec
+{
+    enum Type
+    {
+        /*
+         * long long, microseconds since 1970-01-01 00:00:00 UTC
+         */
+        kTimestamp = 0,
+        /*
+         * float
+         */
+        kFloat32,
+        /*
+         * double
+         */
+        kFloat64
+    };
+
+    ColumnSpec(const std::string& column_name, const Type column_type)
+        : name(column_name),
+        type(column_type)
+    {
+    }
+
+    std::string name;
+    Type type;
+};
+
+/**
+ * @brief Writes a table of fixed width columns to a stream in batches of
+ * rows.
+ *
+ * Each batch is encoded apart from writing it, so batches can be encoded
+ * on several threads and written in order. Values are written little
+ * endian on every machine.
+ */
+class ColumnWriter
+{
+public:
+    ColumnWriter(const std::vector<ColumnSpec>& columns)
+        : columns_(columns),
+        written_(0)
+    {
+    }
+
+    virtual ~ColumnWriter()
+    {
+    }
+
+    /**
+     * @returns the columns of the table
+     */
+    const std::vector<ColumnSpec>& Columns() const
+    {
+        return columns_;
+    }
+
+    /**
+     * Write what comes before the first batch
+     * @param[in] os the stream
+     */
+    virtual void Begin(std::ostream& os) = 0;
+
+    /**
+     * Encode a batch, safe to call from several threads at once
+     * @param[in] rows the number of rows
+     * @param[in] values one array of rows values per column, of the type
+     * of the column
+     * @param[out] batch the encoded batch
+     */
+    virtual void EncodeBatch(
+            const size_t rows,
+            const void* const* values,
+            std::string& batch) const = 0;
+
+    virtual void WriteBatch(std::ostream& os, const std::string& batch);
+
+    /**
+     * Write what comes after the last batch
+     * @param[in] os the stream
+     */
+    virtual void End(std::ostream& os) = 0;
+
+protected:
+    void Write(std::ostream& os, const std::string& bytes);
+    void AppendColumn(
+            std::string& out,
+            const size_t column,
+            const size_t rows,
+            const void* values) const;
+
+    std::vector<ColumnSpec> columns_;
+    /*
+     * the number of bytes written so far
+     */
+    unsigned long long written_;
+};
+
+/**
+ * @brief Writes a table as a flat stream of columns.
+ *
+ * Layout, with every value little endian:
+ *
+ * header
+ * - 8 bytes, "SGP4COLS"
+ * - uint32, format version
+ * - uint32, number of columns
+ * - per column, uint32 type (0 int64 timestamp, 1 float32, 2 float64),
+ *   uint32 name length and the name, padded with zeros to a multiple of 8
+ *   bytes
+ *
+ * batches, each at a multiple of 8 bytes
+ * - uint64, number of rows, 0 after the last batch
+ * - per column, the values padded with zeros to a multiple of 8 bytes
+ */
+class FlatColumnWriter : public ColumnWriter
+{
+public:
+    FlatColumnWriter(const std::vector<ColumnSpec>& columns)
+        : ColumnWriter(columns)
+    {
+    }
+
+    virtual ~FlatColumnWriter()
+    {
+    }
+
+    virtual void Begin(std::ostream& os);
+    virtual void EncodeBatch(
+            const size_t rows,
+            const void* const* values,
+            std::string& batch) const;
+    virtual void End(std::ostream& os);
+};
+
+/**
+ * @brief Writes a table as an Apache Arrow IPC file.
+ *
+ * The file holds the schema and one record batch per batch, with no
+ * nulls, followed by a footer indexing the batches, so it can be mapped
+ * and read in place by Arrow readers. Timestamps are written as
+ * timestamp[us, UTC]. The flatbuffers of the Arrow format are encoded
+ * directly, without the Arrow or flatbuffers libraries.
+ */
+class ArrowColumnWriter : public ColumnWriter
+{
+public:
+    ArrowColumnWriter(const std::vector<ColumnSpec>& columns)
+        : ColumnWriter(columns)
+    {
+    }
+
+    virtual ~ArrowColumnWriter()
+    {
+    }
+
+    virtual void Begin(std::ostream& os);
+    virtual void EncodeBatch(
+            const size_t rows,
+            const void* const* values,
+            std::string& batch) const;
+    virtual void WriteBatch(std::ostream& os, const std::string& batch);
+    virtual void End(std::ostream& os);
+
+private:
+    /*
+     * where each record batch was written, the length of its metadata
+     * with the 8 bytes before it, and the length of its body
+     */
+    struct Block
+    {
+        unsigned long long offset;
+        unsigned long long metadata;
+        unsigned long long body;
+    };
+
+    std::vector<Block> blocks_;
+};
+
+#endif
@@ -0,0 +1,589 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ConjunctionScreener.h"
+
+#include "Globals.h"
+#include "OrbitalElements.h"
+
+#include <algorithm>
+#include <cmath>
+
+/*
+ * steps propagated at once, screened in parallel
+ */
+static const size_t kBlockSteps = 32;
+/*
+ * the most the relative acceleration of two satellites can be, twice
+ * the gravity at the surface of the earth (kilometers per second squared)
+ */
+static const double kMaxAcceleration = 2.0 * kMU / (kXKMPER * kXKMPER);
+/*
+ * width to which the time of closest approach is found (seconds), and
+ * the most iterations spent on it
+ */
+static const double kTimeTolerance = 1.0e-3;
+static const int kMaxIterations = 64;
+
+/*
+ * a satellite at one step, as placed in the grid
+ */
+struct GridEntry
+{
+    double position[3];
+    double velocity[3];
+    /*
+     * the perigee to apogee shell of the orbit, widened by
+     * SGP4::kApsisMargin
+     */
+    double perigee;
+    double apogee;
+    size_t satellite;
+};
+
+/*
+ * order of the results, by time of closest approach then by pair
+ */
+static bool Earlier(const Conjunction& lhs, const Conjunction& rhs)
+{
+    if (lhs.tca != rhs.tca)
+    {
+        return lhs.tca < rhs.tca;
+    }
+    if (lhs.first != rhs.first)
+    {
+        return lhs.first < rhs.first;
+    }
+    return lhs.second < rhs.second;
+}
+
+/*
+ * grid cells are numbered from kCellOffset below the origin, 21 bits per
+ * axis, so that a cell packs into one value ordered by x, y then z
+ */
+static const unsigned long long kCellBits = 21;
+static const unsigned long long kCellMask = (1ULL << kCellBits) - 1;
+static const double kCellOffset = 1048576.0;
+
+/*
+ * grid cell of a coordinate
+ */
+static unsigned long long Cell(const double x, const double size)
+{
+    return static_cast<unsigned long long>(floor(x / size) + kCellOffset)
+        & kCellMask;
+}
+
+static unsigned long long CellKey(
+        const unsigned long long x,
+        const unsigned long long y,
+        const unsigned long long z)
+{
+    return (x << kCellBits | y) << kCellBits | z;
+}
+
+/*
+ * bucket of the row of cells along z holding a cell, in a table of
+ * 2^bits buckets
+ */
+static size_t RowBucket(const unsigned long long key, const unsigned bits)
+{
+    return static_cast<size_t>(
+            ((key >> kCellBits) * 0x9e3779b97f4a7c15ULL) >> (64 - bits));
+}
+
+/**
+ * Initialise every tle, using the threads of the pool
+ * @param[in] tles the catalog
+ * @param[in] pool the threads to screen with, which must outlive this
+ * object
+ */
+ConjunctionScreener::ConjunctionScreener(
+        const std::vector<Tle>& tles,
+        ThreadPool& pool)
+    : pool_(pool),
+      propagator_(tles, pool)
+{
+    /*
+     * the propagator has initialised the tles
+     */
+    for (size_t i = 0; i < tles.size(); i++)
+    {
+        if (!propagator_.IsValid(i))
+        {
+            /*
+             * never valid, left out of the screening
+             */
+            continue;
+        }
+
+        const OrbitalElements elements(tles[i]);
+        const double a = elements.RecoveredSemiMajorAxis() * kXKMPER;
+        Satellite satellite;
+        satellite.index = i;
+        satellite.epoch = elements.Epoch();
+        satellite.perigee = a * (1.0 - elements.Eccentricity());
+        satellite.apogee = a * (1.0 + elements.Eccentricity());
+
+        satellites_.push_back(satellite);
+    }
+}
+
+/**
+ * Find every pair of satellites coming within a distance of each other
+ * @param[in] start the start of the window
+ * @param[in] end the end of the window
+ * @param[in] threshold the miss distance in kilometers
+ * @param[in] step the largest time between screening steps, shortened to
+ * divide the window evenly. Longer steps propagate the catalog less often
+ * but pair each satellite with more of its neighbours
+ * @returns the closest approach of each pair within threshold, one for
+ * each time the pair closes, in order of time. A satellite is skipped
+ * while its propagation fails
+ */
+std::vector<Conjunction> ConjunctionScreener::Screen(
+        const DateTime& start,
+        const DateTime& end,
+        const double threshold,
+        const TimeSpan& step) const
+{
+    std::vector<Conjunction> conjunctions;
+
+    const long long duration = (end - start).Ticks();
+    if (duration <= 0 || step.Ticks() <= 0 || satellites_.size() < 2)
+    {
+        return conjunctions;
+    }
+
+    const long long intervals = (duration + step.Ticks() - 1) / step.Ticks();
+    const TimeSpan interval(duration / intervals);
+    const size_t steps = static_cast<size_t>(intervals) + 1;
+
+    Window window;
+    window.start = start;
+    window.duration = (end - start).TotalSeconds();
+    window.threshold = threshold;
+    window.offset.resize(satellites_.size());
+    for (size_t s = 0; s < satellites_.size(); s++)
+    {
+        window.offset[s] = (start - satellites_[s].epoch).TotalMinutes();
+    }
+
+    const size_t count = Size();
+    std::vector<double> position(3 * count * kBlockSteps);
+    std::vector<double> velocity(3 * count * kBlockSteps);
+    std::vector<SGP4::Status> status(count * kBlockSteps);
+    std::vector<std::vector<Conjunction> > found(kBlockSteps);
+
+    for (size_t first = 0; first < steps; first += kBlockSteps)
+    {
+        const size_t block = std::min(kBlockSteps, steps - first);
+        const long long first_ticks
+            = interval.Ticks() * static_cast<long long>(first);
+
+        propagator_.Propagate(start.AddTicks(first_ticks), interval, block,
+                &position[0], &velocity[0], &status[0]);
+
+        pool_.ParallelFor(block, [&](size_t k)
+        {
+            const double time = TimeSpan(first_ticks + interval.Ticks()
+                    * static_cast<long long>(k)).TotalSeconds();
+
+            found[k].clear();
+            ScreenStep(window, time, interval.TotalSeconds(), k, block,
+                    &position[0], &velocity[0], &status[0], found[k]);
+        });
+
+        for (size_t k = 0; k < block; k++)
+        {
+            conjunctions.insert(conjunctions.end(),
+                    found[k].begin(), found[k].end());
+        }
+    }
+
+    std::sort(conjunctions.begin(), conjunctions.end(), Earlier);
+    return conjunctions;
+}
+
+/*
+ * Screen the pairs closing within half a step either side of one step.
+ * Results of satellite i are at index i * steps + k of the propagated
+ * block.
+ */
+void ConjunctionScreener::ScreenStep(
+        const Window& window,
+        const double time,
+        const double step,
+        const size_t k,
+        const size_t steps,
+        const double* position,
+        const double* velocity,
+        const SGP4::Status* status,
+        std::vector<Conjunction>& conjunctions) const
+{
+    const double begin = std::max(0.0, time - 0.5 * step);
+    const double end = std::min(window.duration, time + 0.5 * step);
+
+    /*
+     * the satellites propagated at this step
+     */
+    std::vector<GridEntry> entries;
+    entries.reserve(satellites_.size());
+    double max_speed = 0.0;
+
+    for (size_t s = 0; s < satellites_.size(); s++)
+    {
+        const Satellite& satellite = satellites_[s];
+        const size_t i = satellite.index * steps + k;
+        if (status[i] != SGP4::kOk)
+        {
+            continue;
+        }
+
+        GridEntry entry;
+        entry.satellite = s;
+        for (size_t c = 0; c < 3; c++)
+        {
+            entry.position[c] = position[3 * i + c];
+            entry.velocity[c] = velocity[3 * i + c];
+        }
+
+        /*
+         * the radius at the step covers decay since epoch
+         */
+        const double* p = entry.position;
+        const double* v = entry.velocity;
+        const double radius = sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        entry.perigee = std::min(satellite.perigee, radius)
+            - SGP4::kApsisMargin;
+        entry.apogee = std::max(satellite.apogee, radius)
+            + SGP4::kApsisMargin;
+        max_speed = std::max(max_speed,
+                sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]));
+
+        entries.push_back(entry);
+    }
+
+    const size_t count = entries.size();
+    if (count < 2)
+    {
+        return;
+    }
+
+    /*
+     * within the interval a pair moving in straight lines closer than
+     * reach may truly come within the threshold, and no pair further
+     * apart than a cell at the step can
+     */
+    const double half = std::max(time - begin, end - time);
+    const double reach = window.threshold
+        + 0.5 * kMaxAcceleration * half * half;
+    const double size = reach + 2.0 * max_speed * half;
+
+    /*
+     * hash the rows of cells along z into buckets, and sort the
+     * satellites by bucket then by cell, so that each row is contiguous
+     * and ordered along z
+     */
+    unsigned bits = 1;
+    while ((static_cast<size_t>(1) << bits) < count)
+    {
+        bits++;
+    }
+    const size_t buckets = static_cast<size_t>(1) << bits;
+
+    std::vector<unsigned long long> cell(count);
+    std::vector<size_t> first(buckets + 1, 0);
+    for (size_t m = 0; m < count; m++)
+    {
+        const double* p = entries[m].position;
+        cell[m] = CellKey(Cell(p[0], size), Cell(p[1], size),
+                Cell(p[2], size));
+        first[RowBucket(cell[m], bits) + 1]++;
+    }
+    for (size_t b = 0; b < buckets; b++)
+    {
+        first[b + 1] += first[b];
+    }
+
+    std::vector<std::pair<unsigned long long, size_t> > sorted(count);
+    std::vector<size_t> next(first.begin(), first.end() - 1);
+    for (size_t m = 0; m < count; m++)
+    {
+        sorted[next[RowBucket(cell[m], bits)]++] = std::make_pair(cell[m], m);
+    }
+    for (size_t b = 0; b < buckets; b++)
+    {
+        if (first[b + 1] - first[b] > 1)
+        {
+            std::sort(sorted.begin() + static_cast<long>(first[b]),
+                    sorted.begin() + static_cast<long>(first[b + 1]));
+        }
+    }
+
+    /*
+     * the keys are kept apart from the entries, so that scanning a row
+     * only reads the entries of the cells looked for
+     */
+    std::vector<GridEntry> grid(count);
+    std::vector<unsigned long long> keys(count);
+    for (size_t n = 0; n < count; n++)
+    {
+        keys[n] = sorted[n].first;
+        grid[n] = entries[sorted[n].second];
+    }
+
+    /*
+     * pair each satellite with the later ones in its own cell and all
+     * of those in half of the neighbouring cells, the other half pairing
+     * with it from theirs: the next cell along z in its own row, and the
+     * three cells along z about it in four of the neighbouring rows
+     */
+    static const int kRows[4][2] = {{0, 1}, {1, -1}, {1, 0}, {1, 1}};
+
+    for (size_t m = 0; m < count; m++)
+    {
+        const unsigned long long key = keys[m];
+        const unsigned long long x = key >> (2 * kCellBits);
+        const unsigned long long y = (key >> kCellBits) & kCellMask;
+        const unsigned long long z = key & kCellMask;
+        const GridEntry& em = grid[m];
+
+        for (size_t row = 0; row < 5; row++)
+        {
+            unsigned long long lo = key;
+            unsigned long long hi = key + 1;
+            size_t n = m + 1;
+            size_t last = first[RowBucket(key, bits) + 1];
+            if (row > 0)
+            {
+                const unsigned long long r = CellKey(
+                        x + static_cast<unsigned long long>(kRows[row - 1][0]),
+                        y + static_cast<unsigned long long>(kRows[row - 1][1]),
+                        0);
+                const size_t b = RowBucket(r, bits);
+                lo = r | (z - 1);
+                hi = r | (z + 1);
+                n = first[b];
+                last = first[b + 1];
+                while (n < last && keys[n] < lo)
+                {
+                    n++;
+                }
+            }
+
+            for (; n < last && keys[n] <= hi; n++)
+            {
+                if (keys[n] < lo)
+                {
+                    continue;
+                }
+
+                const GridEntry& en = grid[n];
+
+                /*
+                 * apogee / perigee filter
+                 */
+                if (std::max(em.perigee, en.perigee)
+                        - std::min(em.apogee, en.apogee) > window.threshold)
+                {
+                    continue;
+                }
+
+                /*
+                 * time filter, the closest approach in straight lines
+                 * within the interval
+                 */
+                double r[3];
+                double v[3];
+                for (size_t i = 0; i < 3; i++)
+                {
+                    r[i] = en.position[i] - em.position[i];
+                    v[i] = en.velocity[i] - em.velocity[i];
+                }
+                const double vv = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+                double t = 0.0;
+                if (vv > 0.0)
+                {
+                    t = -(r[0] * v[0] + r[1] * v[1] + r[2] * v[2]) / vv;
+                    t = std::min(std::max(t, begin - time), end - time);
+                }
+                double dd = 0.0;
+                for (size_t i = 0; i < 3; i++)
+                {
+                    dd += (r[i] + v[i] * t) * (r[i] + v[i] * t);
+                }
+                if (dd > reach * reach)
+                {
+                    continue;
+                }
+
+                /*
+                 * in catalog order
+                 */
+                const size_t sa = std::min(em.satellite, en.satellite);
+                const size_t sb = std::max(em.satellite, en.satellite);
+                Conjunction conjunction;
+                if (Refine(window, sa, sb, begin, end, conjunction))
+                {
+                    conjunctions.push_back(conjunction);
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Find the closest approach of two satellites within an interval, as the
+ * root of the range-rate by the Illinois variant of regula falsi. Only a
+ * root inside the interval counts, a closest approach at its end
+ * belonging to the neighbouring step, unless the end is one of the
+ * window.
+ * @returns whether the satellites come within the threshold
+ */
+bool ConjunctionScreener::Refine(
+        const Window& window,
+        const size_t a,
+        const size_t b,
+        const double begin,
+        const double end,
+        Conjunction& conjunction) const
+{
+    double r[3];
+    double v[3];
+
+    if (!RelativeState(window, a, b, begin, r, v))
+    {
+        return false;
+    }
+    double t0 = begin;
+    double f0 = r[0] * v[0] + r[1] * v[1] + r[2] * v[2];
+
+    if (!RelativeState(window, a, b, end, r, v))
+    {
+        return false;
+    }
+    double t1 = end;
+    double f1 = r[0] * v[0] + r[1] * v[1] + r[2] * v[2];
+
+    double tca;
+    if (f0 < 0.0 && f1 > 0.0)
+    {
+        int side = 0;
+        for (int i = 0; i < kMaxIterations && t1 - t0 > kTimeTolerance; i++)
+        {
+            const double t = (t0 * f1 - t1 * f0) / (f1 - f0);
+            if (!RelativeState(window, a, b, t, r, v))
+            {
+                return false;
+            }
+            const double f = r[0] * v[0] + r[1] * v[1] + r[2] * v[2];
+
+            if (f < 0.0)
+            {
+                t0 = t;
+                f0 = f;
+                if (side == -1)
+                {
+                    f1 *= 0.5;
+                }
+                side = -1;
+            }
+            else if (f > 0.0)
+            {
+                t1 = t;
+                f1 = f;
+                if (side == 1)
+                {
+                    f0 *= 0.5;
+                }
+                side = 1;
+            }
+            else
+            {
+                t0 = t;
+                t1 = t;
+            }
+        }
+        tca = 0.5 * (t0 + t1);
+    }
+    else if (f0 >= 0.0 && begin <= 0.0)
+    {
+        tca = begin;
+    }
+    else if (f1 <= 0.0 && end >= window.duration)
+    {
+        tca = end;
+    }
+    else
+    {
+        return false;
+    }
+
+    if (!RelativeState(window, a, b, tca, r, v))
+    {
+        return false;
+    }
+    const double distance = sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2]);
+    if (distance > window.threshold)
+    {
+        return false;
+    }
+
+    conjunction.first = satellites_[a].index;
+    conjunction.second = satellites_[b].index;
+    conjunction.tca = window.start.AddSeconds(tca);
+    conjunction.distance = distance;
+    conjunction.speed = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    return true;
+}
+
+/*
+ * Position and velocity of satellite b relative to satellite a
+ * @returns false if either propagation fails
+ */
+bool ConjunctionScreener::RelativeState(
+        const Window& window,
+        const size_t a,
+        const size_t b,
+        const double time,
+        double* position,
+        double* velocity) const
+{
+    Eci eci_a(window.start, Vector());
+    Eci eci_b(window.start, Vector());
+
+    if (propagator_.TryFindPosition(satellites_[a].index,
+                window.offset[a] + time / 60.0, eci_a) != SGP4::kOk
+            || propagator_.TryFindPosition(satellites_[b].index,
+                window.offset[b] + time / 60.0, eci_b) != SGP4::kOk)
+    {
+        return false;
+    }
+
+    const Vector pa = eci_a.Position();
+    const Vector pb = eci_b.Position();
+    const Vector va = eci_a.Velocity();
+    const Vector vb = eci_b.Velocity();
+    position[0] = pb.x - pa.x;
+    position[1] = pb.y - pa.y;
+    position[2] = pb.z - pa.z;
+    velocity[0] = vb.x - va.x;
+    velocity[1] = vb.y - va.y;
+    velocity[2] = vb.z - va.z;
+    return true;
+}
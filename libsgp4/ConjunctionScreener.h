@@ -0,0 +1,164 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef CONJUNCTIONSCREENER_H_
+#define CONJUNCTIONSCREENER_H_
+
+#include "CatalogPropagator.h"
+#include "SGP4.h"
+#include "ThreadPool.h"
+#include "Tle.h"
+#include "DateTime.h"
+#include "TimeSpan.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief A close approach between two satellites of a catalog.
+ */
+struct Conjunction
+{
+    /*
+     * the catalog indices of the satellites, first < second
+     */
+    size_t first;
+    size_t second;
+    /*
+     * the time of closest approach
+     */
+    DateTime tca;
+    /*
+     * the miss distance in kilometers
+     */
+    double distance;
+    /*
+     * the relative speed at closest approach in kilometers per second
+     */
+    double speed;
+};
+
+/**
+ * @brief Finds close approaches between every pair of satellites in a
+ * catalog.
+ *
+ * The catalog is propagated at regular steps across the window, each
+ * step covering the half step either side of it. Pairs are sieved in
+ * stages:
+ *
+ * - at each step the satellites are hashed into a uniform grid whose
+ *   cells are as wide as the distance two satellites can close within
+ *   half a step, so only satellites in neighbouring cells are paired;
+ * - a pair is dropped if the radial shells between the perigees and
+ *   apogees of the two orbits do not come within the threshold;
+ * - a pair is dropped if, moving in straight lines from the step, the
+ *   satellites stay apart by more than the threshold and a bound on the
+ *   bending of their paths over the half step.
+ *
+ * The time of closest approach of each remaining pair is found to a
+ * millisecond as the root of the range-rate, propagating both satellites
+ * with SGP4. Steps are screened in parallel across the threads of a
+ * ThreadPool.
+ *
+ * A ConjunctionScreener must only be used by one thread at a time.
+ */
+class ConjunctionScreener
+{
+public:
+    ConjunctionScreener(const std::vector<Tle>& tles, ThreadPool& pool);
+
+    virtual ~ConjunctionScreener()
+    {
+    }
+
+    /**
+     * @returns the number of satellites in the catalog
+     */
+    size_t Size() const
+    {
+        return propagator_.Size();
+    }
+
+    std::vector<Conjunction> Screen(
+            const DateTime& start,
+            const DateTime& end,
+            const double threshold,
+            const TimeSpan& step = TimeSpan(0, 0, 30)) const;
+
+private:
+    struct Satellite
+    {
+        /*
+         * the catalog index
+         */
+        size_t index;
+        DateTime epoch;
+        /*
+         * the perigee and apogee radius in kilometers
+         */
+        double perigee;
+        double apogee;
+    };
+
+    /*
+     * the screening window, times in seconds from its start
+     */
+    struct Window
+    {
+        DateTime start;
+        double duration;
+        double threshold;
+        /*
+         * minutes from the epoch of each satellite to the start
+         */
+        std::vector<double> offset;
+    };
+
+    void ScreenStep(
+            const Window& window,
+            const double time,
+            const double step,
+            const size_t k,
+            const size_t steps,
+            const double* position,
+            const double* velocity,
+            const SGP4::Status* status,
+            std::vector<Conjunction>& conjunctions) const;
+    bool Refine(
+            const Window& window,
+            const size_t a,
+            const size_t b,
+            const double begin,
+            const double end,
+            Conjunction& conjunction) const;
+    bool RelativeState(
+            const Window& window,
+            const size_t a,
+            const size_t b,
+            const double time,
+            double* position,
+            double* velocity) const;
+
+    ThreadPool& pool_;
+    CatalogPropagator propagator_;
+    /*
+     * the satellites that could be initialised, in catalog order
+     */
+    std::vector<Satellite> satellites_;
+};
+
+#endif
@@ -18,6 +18,7 @@
 #include "Eci.h"
 
 #include "Globals.h"
+#include "SimdKernels.h"
 #include "Util.h"
 
 /**
@@ -74,11 +75,21 @@ void Eci::ToEci(const DateTime& dt, const CoordGeodetic &geo)
  * @returns the position in geodetic form
  */
 CoordGeodetic Eci::ToGeodetic() const
+{
+    return ToGeodetic(m_dt.ToGreenwichSiderealTime());
+}
+
+/**
+ * Converts to geodetic form with the Greenwich sidereal time found
+ * beforehand, as by SiderealTime, for many positions at the same time
+ * @param[in] gmst the Greenwich sidereal time of the position in radians
+ * @returns the position in geodetic form
+ */
+CoordGeodetic Eci::ToGeodetic(const double gmst) const
 {
     const double theta = Util::AcTan(m_position.y, m_position.x);
 
-    const double lon = Util::WrapNegPosPI(theta
-            - m_dt.ToGreenwichSiderealTime());
+    const double lon = Util::WrapNegPosPI(theta - gmst);
 
     const double r = sqrt((m_position.x * m_position.x)
             + (m_position.y * m_position.y));
@@ -104,3 +115,52 @@ CoordGeodetic Eci::ToGeodetic() const
 
     return CoordGeodetic(lat, lon, alt, true);
 }
+
+/**
+ * Converts many positions to geodetic form in single precision, as the
+ * double precision overload below but with twice the positions to each
+ * vector instruction. For low earth orbits latitude is within 1.5e-7
+ * radians, longitude within 4e-7 radians and altitude within 2.5 m of
+ * ToGeodetic() for the same positions.
+ * @param[in] position 3 * count values, x y z in kilometers
+ * @param[in] gmst count Greenwich sidereal times in radians, one per
+ * position, as DateTime::ToGreenwichSiderealTime() or
+ * SiderealTime::FindGrid()
+ * @param[in] count the number of positions
+ * @param[out] geodetic 3 * count values, latitude and longitude in
+ * radians and altitude in kilometers
+ */
+void Eci::ToGeodetic(
+        const float* position,
+        const double* gmst,
+        const size_t count,
+        float* geodetic)
+{
+    SimdDispatch().geodetic_float(position, gmst, count, geodetic);
+}
+
+/**
+ * Converts many positions to geodetic form, as ToGeodetic() but without
+ * iterating: the latitude is taken in two steps of Bowring's method,
+ * with the widest SIMD kernels of the cpu. From the surface of the earth
+ * out to geostationary orbit latitude is within 1e-12 radians, longitude
+ * within 2e-15 radians and, within 80 degrees of the equator, altitude
+ * within 2e-10 km of ToGeodetic() for the same positions. Most of this
+ * is ToGeodetic() itself, the tolerance of its iteration and, nearer the
+ * poles, the precision lost to r / cos(lat).
+ * @param[in] position 3 * count values, x y z in kilometers
+ * @param[in] gmst count Greenwich sidereal times in radians, one per
+ * position, as DateTime::ToGreenwichSiderealTime() or
+ * SiderealTime::FindGrid()
+ * @param[in] count the number of positions
+ * @param[out] geodetic 3 * count values, latitude and longitude in
+ * radians and altitude in kilometers
+ */
+void Eci::ToGeodetic(
+        const double* position,
+        const double* gmst,
+        const size_t count,
+        double* geodetic)
+{
+    SimdDispatch().geodetic(position, gmst, count, geodetic);
+}
@@ -22,6 +22,8 @@
 #include "Vector.h"
 #include "DateTime.h"
 
+#include <cstddef>
+
 /**
  * @brief Stores an Earth-centered inertial position for a particular time.
  */
@@ -139,6 +141,18 @@ public:
      * @returns the position in geodetic form
      */
     CoordGeodetic ToGeodetic() const;
+    CoordGeodetic ToGeodetic(const double gmst) const;
+
+    static void ToGeodetic(
+            const float* position,
+            const double* gmst,
+            const size_t count,
+            float* geodetic);
+    static void ToGeodetic(
+            const double* position,
+            const double* gmst,
+            const size_t count,
+            double* geodetic);
 
 private:
     void ToEci(const DateTime& dt, const CoordGeodetic& geo);
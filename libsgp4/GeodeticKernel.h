@@ -0,0 +1,164 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GEODETICKERNEL_H_
+#define GEODETICKERNEL_H_
+
+#include "Globals.h"
+#include "SimdMath.h"
+
+#include <cstddef>
+
+/*
+ * The geodetic position of Eci::ToGeodetic(), evaluated for Lanes<V>()
+ * positions at once. Included by the instruction set specific
+ * translation units, which must provide Sqrt(V) before including this
+ * file. Positions and results are in the precision of the lanes; the
+ * longitude is formed in double, where the sidereal time keeps its
+ * precision.
+ */
+namespace
+{
+    /*
+     * the number of Bowring steps, one leaves the latitude up to 1e-8
+     * radians out at geostationary altitude and two take it to the
+     * rounding of double
+     */
+    const int kBowringSteps = 2;
+
+    /**
+     * The sine and cosine of the angle of (q, p)
+     */
+    template <typename V>
+    inline void Normalize(const V& p, const V& q, V& sinx, V& cosx)
+    {
+        const V h = Sqrt(p * p + q * q);
+        const V inverse = 1.0 / Select(h > 0.0, h, Broadcast<V>(1.0));
+        sinx = Select(h > 0.0, p * inverse, Broadcast<V>(0.0));
+        cosx = Select(h > 0.0, q * inverse, Broadcast<V>(1.0));
+    }
+
+    /**
+     * The GeodeticKernel, or GeodeticKernelFloat, for lane type V
+     */
+    template <typename V>
+    void FindGeodetic(
+            const typename Element<V>::Type* position,
+            const double* gmst,
+            const size_t count,
+            typename Element<V>::Type* geodetic)
+    {
+        typedef typename Element<V>::Type E;
+
+        static const E a = static_cast<E>(kXKMPER);
+        static const E b = static_cast<E>(kXKMPER * (1.0 - kF));
+        static const E e2 = static_cast<E>(kF * (2.0 - kF));
+        static const E ep2 = static_cast<E>(
+                kF * (2.0 - kF) / ((1.0 - kF) * (1.0 - kF)));
+        static const E flattening = static_cast<E>(1.0 - kF);
+
+        const size_t lanes = Lanes<V>();
+
+        for (size_t first = 0; first < count; first += lanes)
+        {
+            const size_t valid = count - first < lanes ? count - first : lanes;
+
+            const V x = LoadStrided<V>(position, 3, first, valid);
+            const V y = LoadStrided<V>(position + 1, 3, first, valid);
+            const V z = LoadStrided<V>(position + 2, 3, first, valid);
+
+            /*
+             * the angle in the half plane x >= 0, where it keeps more of
+             * the precision of the lanes, taken to the full circle in
+             * double with the longitude
+             */
+            const V theta = ArcTan2(y, Abs(x));
+            const V r = Sqrt(x * x + y * y);
+
+            /*
+             * Bowring's method, from the reduced latitude of a sphere
+             * squashed to the ellipsoid, the latitude is the direction
+             * (d, n) and each step takes the reduced latitude from it
+             */
+            V sin_beta;
+            V cos_beta;
+            Normalize(z, flattening * r, sin_beta, cos_beta);
+
+            V n = z;
+            V d = r;
+            for (int i = 0; i < kBowringSteps; i++)
+            {
+                n = z + ep2 * b * sin_beta * sin_beta * sin_beta;
+                d = r - e2 * a * cos_beta * cos_beta * cos_beta;
+                if (i + 1 < kBowringSteps)
+                {
+                    Normalize(flattening * n, d, sin_beta, cos_beta);
+                }
+            }
+
+            const V lat = ArcTan2(n, d);
+
+            /*
+             * altitude, the distance to the point of the ellipsoid under
+             * the position, which holds at every latitude and leaves the
+             * errors of the latitude to second order
+             */
+            V sin_lat;
+            V cos_lat;
+            Normalize(n, d, sin_lat, cos_lat);
+            const V c = 1.0 / Sqrt(1.0 - e2 * sin_lat * sin_lat);
+            const V dr = r - a * c * cos_lat;
+            const V dz = z - a * c * flattening * flattening * sin_lat;
+            const V distance = Sqrt(dr * dr + dz * dz);
+            const V alt = Select(dr * cos_lat + dz * sin_lat < 0.0,
+                    -distance, distance);
+
+            E values[3][sizeof(V) / sizeof(E)];
+            Store(values[0], lat);
+            Store(values[1], theta);
+            Store(values[2], alt);
+
+            for (size_t j = 0; j < valid; j++)
+            {
+                /*
+                 * longitude in [-pi, pi)
+                 */
+                double theta = values[1][j];
+                if (position[3 * (first + j)] < 0.0)
+                {
+                    theta = (theta < 0.0 ? -kPI : kPI) - theta;
+                }
+                double lon = theta - gmst[first + j];
+                if (lon < -kPI)
+                {
+                    lon += kTWOPI;
+                }
+                if (lon >= kPI)
+                {
+                    lon -= kTWOPI;
+                }
+
+                E* out = geodetic + 3 * (first + j);
+                out[0] = values[0][j];
+                out[1] = static_cast<E>(lon);
+                out[2] = values[2][j];
+            }
+        }
+    }
+}
+
+#endif
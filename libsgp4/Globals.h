@@ -18,40 +18,29 @@
 #ifndef GLOBALS_H_
 #define GLOBALS_H_
 
+#include "Gravity.h"
+
 #include <cmath>
 
 const double kAE = 1.0;
 const double kQ0 = 120.0;
 const double kS0 = 78.0;
-const double kMU = 398600.8;
-const double kXKMPER = 6378.135;
-const double kXJ2 = 1.082616e-3;
-const double kXJ3 = -2.53881e-6;
-const double kXJ4 = -1.65597e-6;
-
-/*
- * alternative XKE
- * affects final results
- * aiaa-2006-6573
- * const double kXKE = 60.0 / sqrt(kXKMPER * kXKMPER * kXKMPER / kMU);
- * dundee
- * const double kXKE = 7.43669161331734132e-2;
- */
-const double kXKE = 60.0 / sqrt(kXKMPER * kXKMPER * kXKMPER / kMU);
-const double kCK2 = 0.5 * kXJ2 * kAE * kAE;
-const double kCK4 = -0.375 * kXJ4 * kAE * kAE * kAE * kAE;
 
 /*
- * alternative QOMS2T
- * affects final results
- * aiaa-2006-6573
- * #define QOMS2T   (pow(((Q0 - S0) / XKMPER), 4.0))
- * dundee
- * #define QOMS2T   (1.880279159015270643865e-9)
+ * the constants of the default gravity model, for code outside the
+ * propagator; SGP4Model takes its constants from its gravity model
  */
-const double kQOMS2T = pow(((kQ0 - kS0) / kXKMPER), 4.0);
+const double kMU = Wgs72::kMU;
+const double kXKMPER = Wgs72::kXKMPER;
+const double kXJ2 = Wgs72::kXJ2;
+const double kXJ3 = Wgs72::kXJ3;
+const double kXJ4 = Wgs72::kXJ4;
+const double kXKE = Wgs72::kXKE;
+const double kCK2 = Wgs72::kCK2;
+const double kCK4 = Wgs72::kCK4;
+const double kQOMS2T = Wgs72::kQOMS2T;
+const double kS = Wgs72::kS;
 
-const double kS = kAE * (1.0 + kS0 / kXKMPER);
 const double kPI = 3.14159265358979323846264338327950288419716939937510582;
 const double kTWOPI = 2.0 * kPI;
 const double kTWOTHIRD = 2.0 / 3.0;
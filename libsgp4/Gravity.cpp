@@ -0,0 +1,39 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "Gravity.h"
+
+/*
+ * definitions for the constants, needed where one is bound to a reference
+ */
+#define GRAVITY_CONSTANTS(Model) \
+    constexpr double Model::kMU; \
+    constexpr double Model::kXKMPER; \
+    constexpr double Model::kXJ2; \
+    constexpr double Model::kXJ3; \
+    constexpr double Model::kXJ4; \
+    constexpr double Model::kXKE; \
+    constexpr double Model::kCK2; \
+    constexpr double Model::kCK4; \
+    constexpr double Model::kQOMS2T; \
+    constexpr double Model::kS;
+
+GRAVITY_CONSTANTS(Wgs72Old)
+GRAVITY_CONSTANTS(Wgs72)
+GRAVITY_CONSTANTS(Wgs84)
+
+#undef GRAVITY_CONSTANTS
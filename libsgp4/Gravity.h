@@ -0,0 +1,111 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef GRAVITY_H_
+#define GRAVITY_H_
+
+/*
+ * Gravity models for the propagator, each a set of constants given as a
+ * template argument to SGP4Model and SGP4BatchModel. Distances are in
+ * earth radii (kAE is one) and times in minutes, as used by SGP4.
+ *
+ * kXKE and kQOMS2T are derived from the other constants; C++11 cannot
+ * evaluate sqrt and pow in a constant expression, so they are written out
+ * as the nearest double to the formula given.
+ *
+ * kId identifies the model in files of initialised models, which only
+ * the same model can read back.
+ */
+
+/**
+ * @brief The original WGS-72 constants of the SGP4 reference code
+ * (Spacetrack report #3), with the truncated value of XKE. Use for
+ * comparison with old implementations.
+ */
+struct Wgs72Old
+{
+    static constexpr unsigned int kId = 1;
+    static constexpr double kMU = 398600.79964;
+    static constexpr double kXKMPER = 6378.135;
+    static constexpr double kXJ2 = 1.082616e-3;
+    static constexpr double kXJ3 = -2.53881e-6;
+    static constexpr double kXJ4 = -1.65597e-6;
+    static constexpr double kXKE = 0.0743669161;
+    static constexpr double kCK2 = 0.5 * kXJ2;
+    static constexpr double kCK4 = -0.375 * kXJ4;
+    /*
+     * pow((120.0 - 78.0) / kXKMPER, 4.0)
+     */
+    static constexpr double kQOMS2T = 1.8802791590152709e-9;
+    static constexpr double kS = 1.0 + 78.0 / kXKMPER;
+};
+
+/**
+ * @brief The WGS-72 constants, as used to generate the element sets
+ * distributed by Space-Track. The default model.
+ */
+struct Wgs72
+{
+    static constexpr unsigned int kId = 2;
+    static constexpr double kMU = 398600.8;
+    static constexpr double kXKMPER = 6378.135;
+    static constexpr double kXJ2 = 1.082616e-3;
+    static constexpr double kXJ3 = -2.53881e-6;
+    static constexpr double kXJ4 = -1.65597e-6;
+    /*
+     * 60.0 / sqrt(kXKMPER * kXKMPER * kXKMPER / kMU), as aiaa-2006-6573
+     * alternative XKE, affects final results
+     * dundee: 7.43669161331734132e-2
+     */
+    static constexpr double kXKE = 7.4366916133173422e-2;
+    static constexpr double kCK2 = 0.5 * kXJ2;
+    static constexpr double kCK4 = -0.375 * kXJ4;
+    /*
+     * pow((120.0 - 78.0) / kXKMPER, 4.0), as aiaa-2006-6573
+     * alternative QOMS2T, affects final results
+     * dundee: 1.880279159015270643865e-9
+     */
+    static constexpr double kQOMS2T = 1.8802791590152709e-9;
+    static constexpr double kS = 1.0 + 78.0 / kXKMPER;
+};
+
+/**
+ * @brief The WGS-84 constants. Element sets are fitted with WGS-72, so
+ * this only suits elements known to have been generated with WGS-84.
+ */
+struct Wgs84
+{
+    static constexpr unsigned int kId = 3;
+    static constexpr double kMU = 398600.5;
+    static constexpr double kXKMPER = 6378.137;
+    static constexpr double kXJ2 = 1.08262998905e-3;
+    static constexpr double kXJ3 = -2.53215306e-6;
+    static constexpr double kXJ4 = -1.61098761e-6;
+    /*
+     * 60.0 / sqrt(kXKMPER * kXKMPER * kXKMPER / kMU)
+     */
+    static constexpr double kXKE = 7.4366853168713845e-2;
+    static constexpr double kCK2 = 0.5 * kXJ2;
+    static constexpr double kCK4 = -0.375 * kXJ4;
+    /*
+     * pow((120.0 - 78.0) / kXKMPER, 4.0)
+     */
+    static constexpr double kQOMS2T = 1.8802768006108971e-9;
+    static constexpr double kS = 1.0 + 78.0 / kXKMPER;
+};
+
+#endif
@@ -1,11 +1,17 @@
+#include <ColumnWriter.h>
 #include <SGP4.h>
+#include <SiderealTime.h>
+#include <ThreadPool.h>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <tuple>
 #include <algorithm>
+#include <memory>
 #include <utility>
+#include <cmath>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -54,8 +60,16 @@ bool chron(const Tle& a, const Tle& b)
 class Groundtrack
 {
 public:
+    // GeoJSON is a LineString of longitude and latitude in degrees.
+    // The binary formats hold columns of time, latitude and longitude in
+    // degrees and altitude in kilometers: Columnar and ColumnarFloat as
+    // a FlatColumnWriter stream of doubles or floats, Arrow as an
+    // Apache Arrow IPC file of doubles.
     enum Format {
-        GeoJSON
+        GeoJSON,
+        Columnar,
+        ColumnarFloat,
+        Arrow
     };
     static const int max_prop_days = 7;
 
@@ -82,10 +96,25 @@ public:
     }
 
     std::string Generate(Groundtrack::Format format) 
+    {
+        std::ostringstream os;
+        Generate(format, os);
+        return os.str();
+    }
+
+    /**
+     * Write the track to a stream as it is propagated. At most
+     * max_chunk_points points are held at once, so memory does not
+     * grow with the length of the track.
+     */
+    void Generate(Groundtrack::Format format, std::ostream& os)
     {
         size_t num_tles = tles_.size();
 
-        if (num_tles == 0) return "";
+        if (num_tles == 0) return;
+
+        std::unique_ptr<ColumnWriter> writer(NewWriter(format));
+        WriteHeader(writer.get(), os);
 
         DateTime currtime(start_date_);
         DateTime tle_transition(currtime.Add(max_terminal_propagation_));
@@ -93,42 +122,330 @@ public:
                                                              active_tle_+1);
         
 
+        // Collect the times covered by each TLE and propagate them
+        // together, which lets SGP4 vectorise across the time steps.
+        // Long segments are written a chunk at a time.
         SGP4 sgp4(tles_[active_tle_]);
+        std::vector<DateTime> times;
+        std::string text;
+        bool first = true;
         while (currtime < end_date_)
         {
-            Eci eci = sgp4.FindPosition(currtime);
-            CoordGeodetic geo = eci.ToGeodetic();
-            latlons_.push_back(std::make_tuple(currtime, geo));
+            times.push_back(currtime);
 
             if (currtime >= tle_transition && active_tle_ < num_tles - 1) 
             {
+                AddSegment(sgp4, tles_[active_tle_].Epoch(), times,
+                           writer.get(), text, first, os);
+                times.clear();
                 active_tle_++;
                 sgp4.SetTle(tles_[active_tle_]);
                 tle_transition = TLETransitionTime(active_tle_, active_tle_+1);
             }
+            else if (times.size() == max_chunk_points)
+            {
+                AddSegment(sgp4, tles_[active_tle_].Epoch(), times,
+                           writer.get(), text, first, os);
+                times.clear();
+            }
             currtime = currtime.Add(dt_);
         }
+        AddSegment(sgp4, tles_[active_tle_].Epoch(), times,
+                   writer.get(), text, first, os);
+
+        WriteFooter(writer.get(), os);
+    }
+
+    /**
+     * Write the track to a stream, propagating the segments of each TLE
+     * in parallel across the threads of a pool. Segments are split into
+     * pieces of at most max_chunk_points points, a few pieces per thread
+     * are formatted at once and written in order, so the output is the
+     * same as Generate() without a pool.
+     */
+    void Generate(Groundtrack::Format format,
+                  std::ostream& os,
+                  ThreadPool& pool)
+    {
+        if (tles_.empty()) return;
+
+        std::unique_ptr<ColumnWriter> writer(NewWriter(format));
+        WriteHeader(writer.get(), os);
 
-        std::string gt_out;
+        const std::vector<Piece> pieces = SplitPieces();
+        const size_t wave = 2 * pool.Size();
+        std::vector<std::string> texts(wave);
 
-        switch(format)
+        for (size_t begin = 0; begin < pieces.size(); begin += wave)
         {
-        case(Groundtrack::Format::GeoJSON):
-            gt_out = GenGeoJSON();
-            break;
+            const size_t count = std::min(wave, pieces.size() - begin);
+
+            pool.ParallelFor(count, [&](size_t i)
+            {
+                const Piece& piece = pieces[begin + i];
+                const Tle& tle = tles_[piece.tle];
+
+                std::vector<DateTime> times(piece.count);
+                for (size_t j = 0; j < piece.count; ++j)
+                    times[j] = start_date_.AddTicks(dt_.Ticks() *
+                        static_cast<long long>(piece.first + j));
+
+                bool first = (begin + i == 0);
+                texts[i].clear();
+                AppendSegment(SGP4(tle), tle.Epoch(), times, writer.get(),
+                              texts[i], first);
+            });
+
+            for (size_t i = 0; i < count; ++i)
+                WriteText(writer.get(), texts[i], os);
         }
-        return gt_out;
+
+        WriteFooter(writer.get(), os);
     }
 
 private:
+    static const size_t max_chunk_points = 65536;
+
+    // Points first to first + count - 1 of the time grid, all
+    // propagated from one TLE.
+    struct Piece
+    {
+        size_t tle;
+        size_t first;
+        size_t count;
+    };
+
     DateTime                                start_date_;
     DateTime                                end_date_;
     TimeSpan                                dt_;
     std::vector<Tle>                             tles_;
-    std::vector<std::tuple<DateTime, CoordGeodetic> > latlons_;
     size_t                                  active_tle_; // index into tles_.
     const TimeSpan                          max_terminal_propagation_; // 7 days
 
+    /**
+     * The writer of a binary format, or NULL for GeoJSON.
+     */
+    static ColumnWriter* NewWriter(Groundtrack::Format format)
+    {
+        const ColumnSpec::Type type = format == ColumnarFloat
+            ? ColumnSpec::kFloat32 : ColumnSpec::kFloat64;
+
+        std::vector<ColumnSpec> columns;
+        columns.push_back(ColumnSpec("time", ColumnSpec::kTimestamp));
+        columns.push_back(ColumnSpec("latitude", type));
+        columns.push_back(ColumnSpec("longitude", type));
+        columns.push_back(ColumnSpec("altitude", type));
+
+        if (format == Columnar || format == ColumnarFloat)
+            return new FlatColumnWriter(columns);
+        if (format == Arrow)
+            return new ArrowColumnWriter(columns);
+        return NULL;
+    }
+
+    static void WriteHeader(ColumnWriter* writer, std::ostream& os)
+    {
+        if (writer) {
+            writer->Begin(os);
+            return;
+        }
+        os << "{\"type\":\"FeatureCollection\","
+              "\"features\":["
+              "{"
+              "\"type\": \"Feature\","
+              "\"properties\":"
+              "{"
+              "\"name\":\"[...]\""
+              "},"
+              "\"geometry\":"
+              "{"
+              "\"type\":\"LineString\","
+              "\"coordinates\": [";
+    }
+
+    static void WriteFooter(ColumnWriter* writer, std::ostream& os)
+    {
+        if (writer)
+            writer->End(os);
+        else
+            os << "]}}]}";
+    }
+
+    /**
+     * Write the points of a chunk, a batch for the binary formats.
+     */
+    static void WriteText(ColumnWriter* writer,
+                          const std::string& text,
+                          std::ostream& os)
+    {
+        if (text.empty()) return;
+        if (writer)
+            writer->WriteBatch(os, text);
+        else
+            os.write(text.data(), static_cast<std::streamsize>(text.size()));
+    }
+
+    /**
+     * Split the time grid into the pieces Generate() would propagate
+     * from each TLE, switching at the first point at or after each
+     * transition time, which still belongs to the TLE before it.
+     */
+    std::vector<Piece> SplitPieces() const
+    {
+        std::vector<Piece> pieces;
+
+        const long long step = dt_.Ticks();
+        const long long span = (end_date_ - start_date_).Ticks();
+        if (step <= 0 || span <= 0) return pieces;
+
+        const size_t total = static_cast<size_t>((span + step - 1) / step);
+        const size_t num_tles = tles_.size();
+
+        size_t active = active_tle_;
+        size_t current = 0;
+        while (current < total)
+        {
+            size_t last = total - 1;
+            bool transition = false;
+            if (active < num_tles - 1)
+            {
+                const long long offset =
+                    (TLETransitionTime(active, active + 1) -
+                     start_date_).Ticks();
+                size_t k = offset <= 0 ? 0 :
+                    static_cast<size_t>((offset + step - 1) / step);
+                if (k < current) k = current;
+                if (k < total)
+                {
+                    last = k;
+                    transition = true;
+                }
+            }
+
+            for (size_t first = current; first <= last;
+                 first += max_chunk_points)
+            {
+                Piece piece;
+                piece.tle = active;
+                piece.first = first;
+                piece.count = last + 1 - first < max_chunk_points
+                    ? last + 1 - first : max_chunk_points;
+                pieces.push_back(piece);
+            }
+
+            current = last + 1;
+            if (transition) active++;
+        }
+        return pieces;
+    }
+
+    /**
+     * Propagate one TLE to each of the given times and write the
+     * ground positions, each but the first after a comma.
+     */
+    void AddSegment(const SGP4& sgp4,
+                    const DateTime& epoch,
+                    const std::vector<DateTime>& times,
+                    ColumnWriter* writer,
+                    std::string& text,
+                    bool& first,
+                    std::ostream& os) const
+    {
+        // Format the chunk into one buffer, written with a single call.
+        text.clear();
+        AppendSegment(sgp4, epoch, times, writer, text, first);
+        WriteText(writer, text, os);
+    }
+
+    /**
+     * Propagate one TLE to each of the given times and append the
+     * ground positions to text, each but the first after a comma, or
+     * encode them as a batch of a binary format.
+     */
+    void AppendSegment(const SGP4& sgp4,
+                       const DateTime& epoch,
+                       const std::vector<DateTime>& times,
+                       const ColumnWriter* writer,
+                       std::string& text,
+                       bool& first) const
+    {
+        size_t numpoints = times.size();
+        if (numpoints == 0) return;
+
+        std::vector<double> tsince(numpoints);
+        for (size_t i = 0; i < numpoints; ++i)
+            tsince[i] = (times[i] - epoch).TotalMinutes();
+
+        // Only the positions are needed, so skip the velocity terms.
+        std::vector<double> pos(3 * numpoints);
+        sgp4.FindPositions(&tsince[0], numpoints, &pos[0], NULL);
+
+        // The times are a regular grid, so turn the sidereal time from
+        // step to step rather than finding it at each.
+        std::vector<SiderealAngle> angles(numpoints);
+        SiderealTime::FindGrid(times[0], dt_, numpoints, &angles[0]);
+        std::vector<double> gmst(numpoints);
+        for (size_t i = 0; i < numpoints; ++i)
+            gmst[i] = angles[i].angle;
+
+        // Convert the whole segment at once, without iterating.
+        std::vector<double> geo(3 * numpoints);
+        Eci::ToGeodetic(&pos[0], &gmst[0], numpoints, &geo[0]);
+
+        if (writer) {
+            AppendBatch(*writer, times, geo, text);
+            return;
+        }
+
+        for (size_t i = 0; i < numpoints; ++i)
+        {
+            if (!first) text += ',';
+            first = false;
+            text += '[';
+            AppendLonLat(text, Util::RadiansToDegrees(geo[3 * i + 1]));
+            text += ',';
+            AppendLonLat(text, Util::RadiansToDegrees(geo[3 * i]));
+            text += ']';
+        }
+    }
+
+    /**
+     * Encode the points of a chunk as one batch of columns.
+     */
+    static void AppendBatch(const ColumnWriter& writer,
+                            const std::vector<DateTime>& times,
+                            const std::vector<double>& geo,
+                            std::string& text)
+    {
+        size_t numpoints = times.size();
+
+        std::vector<long long> micros(numpoints);
+        std::vector<double> columns(3 * numpoints);
+        for (size_t i = 0; i < numpoints; ++i)
+        {
+            micros[i] = (times[i].Ticks() - UnixEpoch) / TicksPerMicrosecond;
+            columns[i] = Util::RadiansToDegrees(geo[3 * i]);
+            columns[numpoints + i] = Util::RadiansToDegrees(geo[3 * i + 1]);
+            columns[2 * numpoints + i] = geo[3 * i + 2];
+        }
+
+        // Narrow to floats when the writer holds floats.
+        const bool narrow =
+            writer.Columns()[1].type == ColumnSpec::kFloat32;
+        std::vector<float> floats;
+        if (narrow) floats.assign(columns.begin(), columns.end());
+
+        const void* values[4] = { &micros[0] };
+        for (size_t k = 0; k < 3; ++k)
+        {
+            if (narrow)
+                values[k + 1] = &floats[k * numpoints];
+            else
+                values[k + 1] = &columns[k * numpoints];
+        }
+        writer.EncodeBatch(numpoints, values, text);
+    }
+
     /**
      * Calculate the midpoint in time between TLEs with the
      * given indices into the tle_ vector.
@@ -148,35 +465,47 @@ private:
         return t;
     }
 
-    std::string GenGeoJSON()
+    /**
+     * Append degrees as CoordGeodetic::ToStringLonLat() does, fixed with
+     * three decimals right aligned in seven characters, without going
+     * through a stream. Values too close to halfway between two
+     * decimals to round by scaling are left to snprintf.
+     */
+    static void AppendLonLat(std::string& text, double degrees)
     {
-        std::string geojson_preamble = "{\"type\":\"FeatureCollection\","
-                         "\"features\":["
-                         "{"
-                         "\"type\": \"Feature\","
-                         "\"properties\":"
-                         "{"
-                         "\"name\":\"[...]\""
-                         "},"
-                         "\"geometry\":"
-                         "{"
-                         "\"type\":\"LineString\","
-                         "\"coordinates\": [";
-        std::string geojson_terminator = "]}}]}"; 
-        std::string coords = "";
-
-        size_t numpoints = latlons_.size();
-        for (size_t i = 0; i < numpoints; ++i)
+        char buf[32];
+        const double scaled = fabs(degrees) * 1000.0;
+        const double whole = floor(scaled);
+
+        if (!(scaled < 1e15) || fabs(scaled - whole - 0.5) < 1e-6)
+        {
+            int n = snprintf(buf, sizeof(buf), "%7.3f", degrees);
+            text.append(buf, static_cast<size_t>(n));
+            return;
+        }
+
+        long long units = static_cast<long long>(whole);
+        if (scaled - whole > 0.5) units++;
+
+        // Digits from the last, then the sign, then the padding.
+        char* end = buf + sizeof(buf);
+        char* p = end;
+        for (int i = 0; i < 3; ++i)
         {
-            std::string comma = ",";
-            if (i == numpoints - 1)
-                comma = "";
-            std::string coord = "[" + std::get<1>(latlons_[i]).ToStringLonLat() + 
-                            "]" + comma; 
-            coords.append(coord);
+            *--p = static_cast<char>('0' + units % 10);
+            units /= 10;
         }
-        std::string geojson = geojson_preamble + coords + geojson_terminator;
-        return geojson;
+        *--p = '.';
+        do
+        {
+            *--p = static_cast<char>('0' + units % 10);
+            units /= 10;
+        }
+        while (units > 0);
+        if (std::signbit(degrees)) *--p = '-';
+        while (end - p < 7) *--p = ' ';
+
+        text.append(p, static_cast<size_t>(end - p));
     }
 
 };
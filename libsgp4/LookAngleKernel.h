@@ -0,0 +1,109 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef LOOKANGLEKERNEL_H_
+#define LOOKANGLEKERNEL_H_
+
+#include "CoordTopocentric.h"
+#include "Globals.h"
+#include "SimdKernels.h"
+#include "SimdMath.h"
+
+#include <cstddef>
+
+/*
+ * The look angle of Observer::GetLookAngle(), evaluated for Lanes<V>()
+ * objects at once in a frame built beforehand. Included by the
+ * instruction set specific translation units, which must provide
+ * Sqrt(V) before including this file. Only double lanes are used.
+ */
+namespace
+{
+    /**
+     * The LookAngleKernel for lane type V
+     */
+    template <typename V>
+    void FindLookAngles(
+            const TopocentricFrame& frame,
+            const double* position,
+            const double* velocity,
+            const size_t count,
+            CoordTopocentric* look_angles)
+    {
+        const size_t lanes = Lanes<V>();
+
+        for (size_t first = 0; first < count; first += lanes)
+        {
+            const size_t valid = count - first < lanes ? count - first : lanes;
+
+            /*
+             * the range vector, in the frame and its magnitude
+             */
+            const V rx = LoadStrided<V>(position, 3, first, valid)
+                - frame.position[0];
+            const V ry = LoadStrided<V>(position + 1, 3, first, valid)
+                - frame.position[1];
+            const V rz = LoadStrided<V>(position + 2, 3, first, valid)
+                - frame.position[2];
+
+            const V top_s = frame.south[0] * rx + frame.south[1] * ry
+                + frame.south[2] * rz;
+            const V top_e = frame.east[0] * rx + frame.east[1] * ry;
+            const V top_z = frame.zenith[0] * rx + frame.zenith[1] * ry
+                + frame.zenith[2] * rz;
+
+            const V horizontal = Sqrt(top_s * top_s + top_e * top_e);
+            const V range = Sqrt(rx * rx + ry * ry + rz * rz);
+
+            /*
+             * azimuth clockwise from north, in [0, 2pi)
+             */
+            V az = ArcTan2(top_e, -top_s);
+            az = Select(az < 0.0, az + kTWOPI, az);
+            const V el = ArcTan2(top_z, horizontal);
+
+            V rate = Broadcast<V>(0.0);
+            if (velocity)
+            {
+                const V vx = LoadStrided<V>(velocity, 3, first, valid)
+                    - frame.velocity[0];
+                const V vy = LoadStrided<V>(velocity + 1, 3, first, valid)
+                    - frame.velocity[1];
+                const V vz = LoadStrided<V>(velocity + 2, 3, first, valid)
+                    - frame.velocity[2];
+                rate = (rx * vx + ry * vy + rz * vz) / range;
+            }
+
+            double values[4][sizeof(V) / sizeof(double)];
+            Store(values[0], az);
+            Store(values[1], el);
+            Store(values[2], range);
+            Store(values[3], rate);
+
+            for (size_t j = 0; j < valid; j++)
+            {
+                CoordTopocentric& look = look_angles[first + j];
+                look.azimuth = values[0][j];
+                look.elevation = values[1][j];
+                look.range = values[2][j];
+                look.range_rate = values[3][j];
+            }
+        }
+    }
+}
+
+#endif
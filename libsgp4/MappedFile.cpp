@@ -0,0 +1,75 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Map a file, replacing any file already mapped
+ * @param[in] filename the file to map
+ * @returns false if the file cannot be opened or mapped
+ */
+bool MappedFile::Map(const std::string& filename)
+{
+    Unmap();
+
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    const size_t length = static_cast<size_t>(st.st_size);
+    if (length > 0)
+    {
+        void* data = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            return false;
+        }
+        data_ = static_cast<const char*>(data);
+    }
+    length_ = length;
+    close(fd);
+
+    return true;
+}
+
+/**
+ * Release the mapping, if any
+ */
+void MappedFile::Unmap()
+{
+    if (data_)
+    {
+        munmap(const_cast<char*>(data_), length_);
+    }
+    data_ = NULL;
+    length_ = 0;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef MAPPEDFILE_H_
+#define MAPPEDFILE_H_
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief A whole file mapped read only into memory.
+ *
+ * The mapping is released when the object is destroyed.
+ */
+class MappedFile
+{
+public:
+    MappedFile()
+        : data_(NULL),
+          length_(0)
+    {
+    }
+
+    virtual ~MappedFile()
+    {
+        Unmap();
+    }
+
+    bool Map(const std::string& filename);
+    void Unmap();
+
+    /**
+     * @returns the contents of the file, NULL if nothing is mapped
+     */
+    const char* Data() const
+    {
+        return data_;
+    }
+
+    /**
+     * @returns the length of the file
+     */
+    size_t Length() const
+    {
+        return length_;
+    }
+
+private:
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const char* data_;
+    size_t length_;
+};
+
+#endif
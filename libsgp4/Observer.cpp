@@ -18,6 +18,10 @@
 #include "Observer.h"
 
 #include "CoordTopocentric.h"
+#include "Globals.h"
+#include "SimdKernels.h"
+
+#include <cmath>
 
 /*
  * calculate lookangle between the observer and the passed in Eci object
@@ -80,3 +84,56 @@ CoordTopocentric Observer::GetLookAngle(const Eci &eci)
             range.w,
             rate);
 }
+
+void Observer::GetLookAngles(
+        const DateTime& dt,
+        const double* position,
+        const double* velocity,
+        const size_t count,
+        CoordTopocentric* look_angles) const
+{
+    GetLookAngles(SiderealTime::FindAngle(dt), position, velocity, count,
+            look_angles);
+}
+
+void Observer::GetLookAngles(
+        const SiderealAngle& gmst,
+        const double* position,
+        const double* velocity,
+        const size_t count,
+        CoordTopocentric* look_angles) const
+{
+    static const double mfactor = kTWOPI * (kOMEGA_E / kSECONDS_PER_DAY);
+
+    /*
+     * the Local Mean Sidereal Time of the observer is the Greenwich
+     * sidereal time turned by its longitude
+     */
+    const double sin_lon = sin(m_geo.longitude);
+    const double cos_lon = cos(m_geo.longitude);
+    const double sin_theta = gmst.sine * cos_lon + gmst.cosine * sin_lon;
+    const double cos_theta = gmst.cosine * cos_lon - gmst.sine * sin_lon;
+
+    /*
+     * the observers position, as Eci::ToEci(), and the south, east and
+     * zenith directions from it
+     */
+    const double sin_lat = sin(m_geo.latitude);
+    const double cos_lat = cos(m_geo.latitude);
+    const double c = 1.0 / sqrt(1.0 + kF * (kF - 2.0) * sin_lat * sin_lat);
+    const double s = (1.0 - kF) * (1.0 - kF) * c;
+    const double achcp = (kXKMPER * c + m_geo.altitude) * cos_lat;
+    const double x = achcp * cos_theta;
+    const double y = achcp * sin_theta;
+    const double z = (kXKMPER * s + m_geo.altitude) * sin_lat;
+
+    const TopocentricFrame frame = {
+        { x, y, z },
+        { -mfactor * y, mfactor * x, 0.0 },
+        { sin_lat * cos_theta, sin_lat * sin_theta, -cos_lat },
+        { -sin_theta, cos_theta, 0.0 },
+        { cos_lat * cos_theta, cos_lat * sin_theta, sin_lat }
+    };
+
+    SimdDispatch().look_angles(frame, position, velocity, count, look_angles);
+}
@@ -20,6 +20,9 @@
 
 #include "CoordGeodetic.h"
 #include "Eci.h"
+#include "SiderealTime.h"
+
+#include <cstddef>
 
 class DateTime;
 struct CoordTopocentric;
@@ -87,6 +90,44 @@ public:
      */
     CoordTopocentric GetLookAngle(const Eci &eci);
 
+    /**
+     * Get the look angles for the observers position to many objects at
+     * one time. The topocentric frame is built once and the objects are
+     * transformed with the best SIMD kernels of the cpu.
+     * @param[in] dt the time of the objects
+     * @param[in] position 3 values per object, x y z in kilometers, as
+     * written by SGP4Batch
+     * @param[in] velocity 3 values per object, x y z in kilometers per
+     * second, or NULL to leave the range rates zero
+     * @param[in] count the number of objects
+     * @param[out] look_angles one per object
+     */
+    void GetLookAngles(
+            const DateTime& dt,
+            const double* position,
+            const double* velocity,
+            const size_t count,
+            CoordTopocentric* look_angles) const;
+
+    /**
+     * Get the look angles for the observers position to many objects at
+     * one time, with the Greenwich sidereal time found beforehand, as by
+     * a SiderealTime shared with the conversions of the objects.
+     * @param[in] gmst the Greenwich sidereal time of the objects
+     * @param[in] position 3 values per object, x y z in kilometers, as
+     * written by SGP4Batch
+     * @param[in] velocity 3 values per object, x y z in kilometers per
+     * second, or NULL to leave the range rates zero
+     * @param[in] count the number of objects
+     * @param[out] look_angles one per object
+     */
+    void GetLookAngles(
+            const SiderealAngle& gmst,
+            const double* position,
+            const double* velocity,
+            const size_t count,
+            CoordTopocentric* look_angles) const;
+
 private:
     /**
      * @param[in] dt the date to update the observers position for
@@ -0,0 +1,216 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ObserverNetwork.h"
+
+#include "CoordTopocentric.h"
+#include "Globals.h"
+#include "SimdKernels.h"
+
+#include <cmath>
+
+/**
+ * @param[in] stations the observers positions
+ */
+ObserverNetwork::ObserverNetwork(const std::vector<CoordGeodetic>& stations)
+    : stations_(stations),
+    axial_(stations.size()),
+    z_(stations.size()),
+    sin_lat_(stations.size()),
+    cos_lat_(stations.size()),
+    sin_lon_(stations.size()),
+    cos_lon_(stations.size()),
+    updated_(false),
+    sin_theta_(stations.size()),
+    cos_theta_(stations.size()),
+    x_(stations.size()),
+    y_(stations.size()),
+    vx_(stations.size()),
+    vy_(stations.size())
+{
+    for (size_t i = 0; i < stations_.size(); i++)
+    {
+        const CoordGeodetic& geo = stations_[i];
+
+        /*
+         * take into account earth flattening, as Eci::ToEci()
+         */
+        const double sin_lat = sin(geo.latitude);
+        const double c = 1.0 / sqrt(1.0 + kF * (kF - 2.0) * sin_lat * sin_lat);
+        const double s = (1.0 - kF) * (1.0 - kF) * c;
+
+        sin_lat_[i] = sin_lat;
+        cos_lat_[i] = cos(geo.latitude);
+        sin_lon_[i] = sin(geo.longitude);
+        cos_lon_[i] = cos(geo.longitude);
+        axial_[i] = (kXKMPER * c + geo.altitude) * cos_lat_[i];
+        z_[i] = (kXKMPER * s + geo.altitude) * sin_lat;
+    }
+}
+
+/**
+ * Update the Eci positions of every station, if dt is not the time they
+ * were last updated to
+ * @param[in] dt the time
+ */
+void ObserverNetwork::Update(const DateTime& dt)
+{
+    Update(dt, sidereal_.Find(dt));
+}
+
+/**
+ * Update the Eci positions of every station with the Greenwich sidereal
+ * time found beforehand, if dt is not the time they were last updated to
+ * @param[in] dt the time
+ * @param[in] gmst the Greenwich sidereal time at dt, as by SiderealTime
+ */
+void ObserverNetwork::Update(const DateTime& dt, const SiderealAngle& gmst)
+{
+    if (updated_ && dt == dt_)
+    {
+        return;
+    }
+
+    static const double mfactor = kTWOPI * (kOMEGA_E / kSECONDS_PER_DAY);
+
+    /*
+     * the local mean sidereal time of each station is the Greenwich
+     * sidereal time turned by the longitude of the station
+     */
+    const double sin_gmst = gmst.sine;
+    const double cos_gmst = gmst.cosine;
+
+    for (size_t i = 0; i < stations_.size(); i++)
+    {
+        sin_theta_[i] = sin_gmst * cos_lon_[i] + cos_gmst * sin_lon_[i];
+        cos_theta_[i] = cos_gmst * cos_lon_[i] - sin_gmst * sin_lon_[i];
+        x_[i] = axial_[i] * cos_theta_[i];
+        y_[i] = axial_[i] * sin_theta_[i];
+        vx_[i] = -mfactor * y_[i];
+        vy_[i] = mfactor * x_[i];
+    }
+
+    dt_ = dt;
+    updated_ = true;
+}
+
+/**
+ * @param[in] station the index of the station
+ * @returns the Eci position of the station at the time last updated to
+ */
+Eci ObserverNetwork::GetEci(const size_t station) const
+{
+    Vector position(x_[station], y_[station], z_[station]);
+    Vector velocity(vx_[station], vy_[station], 0.0);
+    position.w = position.Magnitude();
+    velocity.w = velocity.Magnitude();
+
+    return Eci(dt_, position, velocity);
+}
+
+/**
+ * Get the look angle from every station to an object, as
+ * Observer::GetLookAngle()
+ * @param[in] eci the object to find the look angles to
+ * @param[out] look_angles one per station
+ */
+void ObserverNetwork::GetLookAngles(
+        const Eci& eci,
+        CoordTopocentric* look_angles)
+{
+    Update(eci.GetDateTime());
+
+    const Vector& position = eci.Position();
+    const Vector& velocity = eci.Velocity();
+
+    for (size_t i = 0; i < stations_.size(); i++)
+    {
+        const double rx = position.x - x_[i];
+        const double ry = position.y - y_[i];
+        const double rz = position.z - z_[i];
+
+        const double sin_theta = sin_theta_[i];
+        const double cos_theta = cos_theta_[i];
+
+        /*
+         * the range in the south, east and zenith directions
+         */
+        const double top_s = sin_lat_[i] * (cos_theta * rx + sin_theta * ry)
+            - cos_lat_[i] * rz;
+        const double top_e = -sin_theta * rx + cos_theta * ry;
+        const double top_z = cos_lat_[i] * (cos_theta * rx + sin_theta * ry)
+            + sin_lat_[i] * rz;
+
+        const double range = sqrt(rx * rx + ry * ry + rz * rz);
+
+        double az = atan2(top_e, -top_s);
+        if (az < 0.0)
+        {
+            az += kTWOPI;
+        }
+
+        CoordTopocentric& look = look_angles[i];
+        look.azimuth = az;
+        look.elevation = atan2(top_z, sqrt(top_s * top_s + top_e * top_e));
+        look.range = range;
+        look.range_rate = (rx * (velocity.x - vx_[i])
+                + ry * (velocity.y - vy_[i])
+                + rz * velocity.z) / range;
+    }
+}
+
+/**
+ * Get the look angles from every station to many objects at one time,
+ * as Observer::GetLookAngles()
+ * @param[in] dt the time of the objects
+ * @param[in] position 3 values per object, x y z in kilometers, as
+ * written by SGP4Batch
+ * @param[in] velocity 3 values per object, x y z in kilometers per
+ * second, or NULL to leave the range rates zero
+ * @param[in] count the number of objects
+ * @param[out] look_angles count per station, the objects of station 0
+ * first
+ */
+void ObserverNetwork::GetLookAngles(
+        const DateTime& dt,
+        const double* position,
+        const double* velocity,
+        const size_t count,
+        CoordTopocentric* look_angles)
+{
+    Update(dt);
+
+    const LookAngleKernel kernel = SimdDispatch().look_angles;
+
+    for (size_t i = 0; i < stations_.size(); i++)
+    {
+        const double sin_lat = sin_lat_[i];
+        const double cos_lat = cos_lat_[i];
+        const double sin_theta = sin_theta_[i];
+        const double cos_theta = cos_theta_[i];
+
+        const TopocentricFrame frame = {
+            { x_[i], y_[i], z_[i] },
+            { vx_[i], vy_[i], 0.0 },
+            { sin_lat * cos_theta, sin_lat * sin_theta, -cos_lat },
+            { -sin_theta, cos_theta, 0.0 },
+            { cos_lat * cos_theta, cos_lat * sin_theta, sin_lat }
+        };
+
+        kernel(frame, position, velocity, count, look_angles + i * count);
+    }
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef OBSERVERNETWORK_H_
+#define OBSERVERNETWORK_H_
+
+#include "CoordGeodetic.h"
+#include "DateTime.h"
+#include "Eci.h"
+#include "SiderealTime.h"
+
+#include <cstddef>
+#include <vector>
+
+struct CoordTopocentric;
+
+/**
+ * @brief Stores the Eci locations of many observers at one time.
+ *
+ * The stations are held one array per quantity. The parts of each
+ * station that do not change with time are found once, and at each new
+ * time the Greenwich sidereal time is found once and every station is
+ * rotated by it together, giving the same positions as an Observer at
+ * each station without finding the sidereal time and the position of
+ * each station separately. The sidereal time may be passed in, found by
+ * a SiderealTime shared with the conversions of the satellites at the
+ * same time.
+ *
+ * The look angle methods update the stations to the time of the objects
+ * when it changes, so an ObserverNetwork must only be used by one thread
+ * at a time.
+ */
+class ObserverNetwork
+{
+public:
+    ObserverNetwork(const std::vector<CoordGeodetic>& stations);
+
+    virtual ~ObserverNetwork()
+    {
+    }
+
+    /**
+     * @returns the number of stations
+     */
+    size_t Size() const
+    {
+        return stations_.size();
+    }
+
+    /**
+     * @param[in] station the index of the station
+     * @returns the location of the station
+     */
+    CoordGeodetic GetLocation(const size_t station) const
+    {
+        return stations_[station];
+    }
+
+    void Update(const DateTime& dt);
+    void Update(const DateTime& dt, const SiderealAngle& gmst);
+
+    /**
+     * @returns the time the stations were last updated to
+     */
+    DateTime GetDateTime() const
+    {
+        return dt_;
+    }
+
+    Eci GetEci(const size_t station) const;
+
+    void GetLookAngles(const Eci& eci, CoordTopocentric* look_angles);
+    void GetLookAngles(
+            const DateTime& dt,
+            const double* position,
+            const double* velocity,
+            const size_t count,
+            CoordTopocentric* look_angles);
+
+private:
+    std::vector<CoordGeodetic> stations_;
+    /*
+     * earth fixed, the distance from the earth axis and along it in
+     * kilometers, and the sine and cosine of the latitude and longitude
+     */
+    std::vector<double> axial_;
+    std::vector<double> z_;
+    std::vector<double> sin_lat_;
+    std::vector<double> cos_lat_;
+    std::vector<double> sin_lon_;
+    std::vector<double> cos_lon_;
+    /*
+     * at dt_, the sine and cosine of the local mean sidereal time, and
+     * the x y Eci position in kilometers and velocity in kilometers per
+     * second, z and the z velocity do not change
+     */
+    bool updated_;
+    DateTime dt_;
+    SiderealTime sidereal_;
+    std::vector<double> sin_theta_;
+    std::vector<double> cos_theta_;
+    std::vector<double> x_;
+    std::vector<double> y_;
+    std::vector<double> vx_;
+    std::vector<double> vy_;
+};
+
+#endif
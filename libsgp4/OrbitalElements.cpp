@@ -18,8 +18,24 @@
 #include "OrbitalElements.h"
 
 #include "Tle.h"
+#include "Gravity.h"
 
+/**
+ * Extract the elements of a tle, recovered with the default gravity
+ * model, Wgs72
+ * @param[in] tle the tle
+ */
 OrbitalElements::OrbitalElements(const Tle& tle)
+    : OrbitalElements(tle, Wgs72())
+{
+}
+
+/**
+ * Extract the elements of a tle, recovered with the given gravity model
+ * @param[in] tle the tle
+ */
+template <typename Gravity>
+OrbitalElements::OrbitalElements(const Tle& tle, const Gravity&)
 {
     /*
      * extract and format tle data
@@ -37,14 +53,14 @@ OrbitalElements::OrbitalElements(const Tle& tle)
      * recover original mean motion (xnodp) and semimajor axis (aodp)
      * from input elements
      */
-    const double a1 = pow(kXKE / MeanMotion(), kTWOTHIRD);
+    const double a1 = pow(Gravity::kXKE / MeanMotion(), kTWOTHIRD);
     const double cosio = cos(Inclination());
     const double theta2 = cosio * cosio;
     const double x3thm1 = 3.0 * theta2 - 1.0;
     const double eosq = Eccentricity() * Eccentricity();
     const double betao2 = 1.0 - eosq;
     const double betao = sqrt(betao2);
-    const double temp = (1.5 * kCK2) * x3thm1 / (betao * betao2);
+    const double temp = (1.5 * Gravity::kCK2) * x3thm1 / (betao * betao2);
     const double del1 = temp / (a1 * a1);
     const double a0 = a1 * (1.0 - del1 * (1.0 / 3.0 + del1 * (1.0 + del1 * 134.0 / 81.0)));
     const double del0 = temp / (a0 * a0);
@@ -60,7 +76,10 @@ OrbitalElements::OrbitalElements(const Tle& tle)
     /*
      * find perigee and period
      */
-    perigee_ = (RecoveredSemiMajorAxis() * (1.0 - Eccentricity()) - kAE) * kXKMPER;
+    perigee_ = (RecoveredSemiMajorAxis() * (1.0 - Eccentricity()) - kAE) * Gravity::kXKMPER;
     period_ = kTWOPI / RecoveredMeanMotion();
 }
 
+template OrbitalElements::OrbitalElements(const Tle&, const Wgs72Old&);
+template OrbitalElements::OrbitalElements(const Tle&, const Wgs72&);
+template OrbitalElements::OrbitalElements(const Tle&, const Wgs84&);
@@ -30,6 +30,8 @@ class OrbitalElements
 {
 public:
     OrbitalElements(const Tle& tle);
+    template <typename Gravity>
+    OrbitalElements(const Tle& tle, const Gravity& gravity);
 
     virtual ~OrbitalElements()
     {
@@ -132,6 +134,13 @@ public:
     }
 
 private:
+    friend class SGP4Base;
+    friend class PropagatorFile;
+
+    OrbitalElements()
+    {
+    }
+
     double mean_anomoly_;
     double ascending_node_;
     double argument_perigee_;
@@ -0,0 +1,668 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "PassPredictor.h"
+
+#include "Globals.h"
+#include "OrbitalElements.h"
+#include "SatelliteException.h"
+#include "SiderealTime.h"
+
+#include <algorithm>
+#include <cmath>
+
+/*
+ * rotation rate of the earth (radians per second)
+ */
+static const double kEarthRate = kTWOPI * kOMEGA_E / kSECONDS_PER_DAY;
+/*
+ * fraction of the least possible range to a satellite used in bounding
+ * the rate of its elevation, covering the perturbations of the orbit and
+ * the tilt of the geodetic horizon from the geocentric one
+ */
+static const double kRangeMargin = 0.9;
+/*
+ * widening of the inclination of an orbit for the short and long
+ * periodic terms of SGP4, and of the angle from the centre of the earth
+ * within which a satellite can be seen for the tilt of the geodetic
+ * horizon (radians)
+ */
+static const double kInclinationMargin = 0.02;
+static const double kCoverageMargin = 0.01;
+/*
+ * factor on the fastest rate a satellite moves around its orbit, covering
+ * the perturbations of the orbit
+ */
+static const double kAngularRateMargin = 1.1;
+/*
+ * factor on the greatest acceleration of a satellite, covering the
+ * perturbations of the orbit
+ */
+static const double kAccelerationMargin = 1.1;
+/*
+ * the longest pass, or gap between passes, that may be missed (seconds),
+ * and the shortest step taken
+ */
+static const double kMinStep = 1.0;
+/*
+ * width to which the times of a pass are found (seconds), and the most
+ * iterations spent on each
+ */
+static const double kTimeTolerance = 1.0e-3;
+static const int kMaxIterations = 64;
+
+/*
+ * Find a root of function, which is fa at a and fb at b and changes sign
+ * between them, by Brent's method. function(t, f) sets f to the value at
+ * t and returns false if it cannot be evaluated.
+ * @returns false if function could not be evaluated
+ */
+template <typename Function>
+static bool FindRoot(
+        const Function& function,
+        double a,
+        double fa,
+        double b,
+        double fb,
+        double& root)
+{
+    double c = b;
+    double fc = fb;
+    double d = b - a;
+    double e = d;
+
+    for (int i = 0; i < kMaxIterations; i++)
+    {
+        if ((fb > 0.0 && fc > 0.0) || (fb < 0.0 && fc < 0.0))
+        {
+            /*
+             * keep the root between b and c
+             */
+            c = a;
+            fc = fa;
+            d = b - a;
+            e = d;
+        }
+        if (fabs(fc) < fabs(fb))
+        {
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+
+        const double tolerance = 0.5 * kTimeTolerance;
+        const double m = 0.5 * (c - b);
+        if (fabs(m) <= tolerance || fb == 0.0)
+        {
+            break;
+        }
+
+        if (fabs(e) >= tolerance && fabs(fa) > fabs(fb))
+        {
+            /*
+             * secant or inverse quadratic interpolation
+             */
+            const double s = fb / fa;
+            double p;
+            double q;
+            if (a == c)
+            {
+                p = 2.0 * m * s;
+                q = 1.0 - s;
+            }
+            else
+            {
+                const double r = fb / fc;
+                q = fa / fc;
+                p = s * (2.0 * m * q * (q - r) - (b - a) * (r - 1.0));
+                q = (q - 1.0) * (r - 1.0) * (s - 1.0);
+            }
+            if (p > 0.0)
+            {
+                q = -q;
+            }
+            else
+            {
+                p = -p;
+            }
+
+            if (2.0 * p < std::min(3.0 * m * q - fabs(tolerance * q),
+                        fabs(e * q)))
+            {
+                e = d;
+                d = p / q;
+            }
+            else
+            {
+                d = m;
+                e = m;
+            }
+        }
+        else
+        {
+            /*
+             * bisection
+             */
+            d = m;
+            e = m;
+        }
+
+        a = b;
+        fa = fb;
+        if (fabs(d) > tolerance)
+        {
+            b += d;
+        }
+        else
+        {
+            b += m > 0.0 ? tolerance : -tolerance;
+        }
+        if (!function(b, fb))
+        {
+            return false;
+        }
+    }
+
+    root = b;
+    return true;
+}
+
+/**
+ * Initialise every tle
+ * @param[in] tles the satellites
+ * @param[in] stations the stations
+ * @param[in] pool the threads to search with, which must outlive this
+ * object
+ */
+PassPredictor::PassPredictor(
+        const std::vector<Tle>& tles,
+        const std::vector<CoordGeodetic>& stations,
+        ThreadPool& pool)
+    : pool_(pool)
+{
+    for (size_t i = 0; i < tles.size(); i++)
+    {
+        try
+        {
+            SGP4 model(tles[i]);
+            const OrbitalElements elements(tles[i]);
+
+            if (model.UsesDeepSpace())
+            {
+                model.SetIntegratorCheckpoints(
+                        SGP4::kDefaultIntegratorCheckpoints);
+            }
+
+            const double a = elements.RecoveredSemiMajorAxis() * kXKMPER;
+            const double e = elements.Eccentricity();
+            Satellite satellite;
+            satellite.index = i;
+            satellite.epoch = elements.Epoch();
+            satellite.perigee = a * (1.0 - e) - SGP4::kApsisMargin;
+            satellite.apogee = a * (1.0 + e) + SGP4::kApsisMargin;
+            /*
+             * speed at perigee, plus the speed of the earth turning
+             * beneath the satellite at apogee
+             */
+            satellite.speed = sqrt(kMU / a * (1.0 + e) / (1.0 - e))
+                + kEarthRate * satellite.apogee;
+            /*
+             * retrograde orbits reach the same latitudes as prograde ones
+             * inclined as far from the equator, and move around the orbit
+             * fastest at perigee. The sun and moon turn deep space orbits
+             * by many degrees from their inclination at epoch, so those
+             * are taken to reach every latitude, as a polar orbit, which
+             * moves between latitudes no slower than any other
+             */
+            satellite.inclination = kPI / 2.0;
+            if (!model.UsesDeepSpace())
+            {
+                satellite.inclination = std::min(kPI / 2.0,
+                        kInclinationMargin
+                        + std::min(elements.Inclination(),
+                            kPI - elements.Inclination()));
+            }
+            satellite.angular_rate = kAngularRateMargin
+                * sqrt(kMU * a * (1.0 - e * e))
+                / (satellite.perigee * satellite.perigee);
+            /*
+             * gravity at perigee, and the coriolis and centrifugal
+             * acceleration of the turning earth
+             */
+            satellite.acceleration = kAccelerationMargin
+                * (kMU / (satellite.perigee * satellite.perigee)
+                        + 2.0 * kEarthRate * satellite.speed
+                        + kEarthRate * kEarthRate * satellite.apogee);
+
+            satellites_.push_back(satellite);
+            models_.push_back(model);
+        }
+        catch (SatelliteException&)
+        {
+            /*
+             * never valid, left out of the search
+             */
+        }
+    }
+
+    for (size_t i = 0; i < stations.size(); i++)
+    {
+        const double lat = stations[i].latitude;
+        const double lon = stations[i].longitude;
+        const double alt = stations[i].altitude;
+        const double sinlat = sin(lat);
+        const double coslat = cos(lat);
+
+        /*
+         * the same as Eci::ToEci() at zero sidereal time
+         */
+        const double c = 1.0 / sqrt(1.0 + kF * (kF - 2.0) * sinlat * sinlat);
+        const double s = pow(1.0 - kF, 2.0) * c;
+        const double achcp = (kXKMPER * c + alt) * coslat;
+
+        Station station;
+        station.position[0] = achcp * cos(lon);
+        station.position[1] = achcp * sin(lon);
+        station.position[2] = (kXKMPER * s + alt) * sinlat;
+        station.up[0] = coslat * cos(lon);
+        station.up[1] = coslat * sin(lon);
+        station.up[2] = sinlat;
+        station.radius = sqrt(station.position[0] * station.position[0]
+                + station.position[1] * station.position[1]
+                + station.position[2] * station.position[2]);
+        station.latitude = asin(station.position[2] / station.radius);
+
+        stations_.push_back(station);
+    }
+}
+
+/**
+ * Find the passes of every satellite over every station
+ * @param[in] start the start of the search
+ * @param[in] end the end of the search
+ * @param[in] min_elevation the elevation in radians above which a
+ * satellite is in view
+ * @returns the passes ordered by satellite, station then time. A
+ * satellite is dropped from the time its propagation fails, ending any
+ * pass in progress
+ */
+std::vector<Pass> PassPredictor::FindPasses(
+        const DateTime& start,
+        const DateTime& end,
+        const double min_elevation) const
+{
+    std::vector<Pass> passes;
+
+    if (!(start < end) || satellites_.empty() || stations_.empty())
+    {
+        return passes;
+    }
+
+    Window window;
+    window.start = start;
+    window.duration = (end - start).TotalSeconds();
+    window.min_elevation = min_elevation;
+    window.gmst = SiderealTime::FindAngle(start).angle;
+    window.offset.resize(satellites_.size());
+    for (size_t s = 0; s < satellites_.size(); s++)
+    {
+        window.offset[s] = (start - satellites_[s].epoch).TotalMinutes();
+    }
+
+    const size_t pairs = satellites_.size() * stations_.size();
+    std::vector<std::vector<Pass> > found(pairs);
+
+    pool_.ParallelFor(pairs, [&](size_t i)
+    {
+        FindPasses(window, i / stations_.size(), i % stations_.size(),
+                found[i]);
+    });
+
+    for (size_t i = 0; i < pairs; i++)
+    {
+        passes.insert(passes.end(), found[i].begin(), found[i].end());
+    }
+
+    return passes;
+}
+
+/*
+ * Find the passes of one satellite over one station
+ */
+void PassPredictor::FindPasses(
+        const Window& window,
+        const size_t satellite,
+        const size_t station,
+        std::vector<Pass>& passes) const
+{
+    const Satellite& sat = satellites_[satellite];
+    const double mask = window.min_elevation;
+
+    Reach reach;
+    reach.mask = window.min_elevation;
+    reach.sinmask = sin(reach.mask);
+    reach.radius = stations_[station].radius;
+    reach.perigee = sat.perigee;
+    reach.speed = sat.speed;
+    /*
+     * at apogee
+     */
+    reach.max_range = (sqrt(sat.apogee * sat.apogee - reach.radius
+                * reach.radius * (1.0 - reach.sinmask * reach.sinmask))
+            - reach.radius * reach.sinmask) / kRangeMargin;
+
+    /*
+     * the height above the cone of the minimum elevation speeds up by the
+     * acceleration of the satellite along the station vertical, and by
+     * that of the range along the cone, which grows with the square of
+     * the speed over the range, at least the height of the perigee
+     */
+    const double spin = sat.speed * sat.speed
+        / (kRangeMargin * std::max(1.0, sat.perigee - reach.radius));
+    reach.rising = sat.acceleration
+        + std::max(0.0, reach.sinmask) * sat.acceleration
+        + std::max(0.0, -reach.sinmask) * (sat.acceleration + spin);
+    reach.falling = sat.acceleration
+        + std::max(0.0, reach.sinmask) * (sat.acceleration + spin)
+        + std::max(0.0, -reach.sinmask) * sat.acceleration;
+
+    /*
+     * the satellite is seen within an angle from the centre of the earth
+     * of the station, greatest at apogee, so must reach the latitude of
+     * the station less that angle. If its orbit never does the pair is
+     * left out
+     */
+    const double coverage = acos(std::min(1.0, reach.radius
+                * cos(reach.mask) / sat.apogee)) - reach.mask
+        + kCoverageMargin;
+    const double latitude = stations_[station].latitude;
+    reach.band = std::max(0.0, fabs(latitude) - coverage);
+    reach.side = latitude < 0.0 ? -1.0 : 1.0;
+    reach.sin_inclination = sin(sat.inclination);
+    reach.angular_rate = sat.angular_rate;
+    if (reach.band > sat.inclination)
+    {
+        return;
+    }
+
+    SGP4::IntegratorParams params = SGP4::IntegratorParams();
+
+    const auto elevation = [&](double time, double& value)
+    {
+        Sample sample;
+        if (!Look(window, satellite, station, params, time, sample))
+        {
+            return false;
+        }
+        value = sample.elevation - mask;
+        return true;
+    };
+    const auto rate = [&](double time, double& value)
+    {
+        Sample sample;
+        if (!Look(window, satellite, station, params, time, sample))
+        {
+            return false;
+        }
+        value = sample.rate;
+        return true;
+    };
+
+    Sample previous;
+    if (!Look(window, satellite, station, params, 0.0, previous))
+    {
+        return;
+    }
+
+    Pass pass;
+    pass.satellite = sat.index;
+    pass.station = station;
+    bool up = previous.elevation >= mask;
+    if (up)
+    {
+        pass.aos = window.start;
+        pass.max_time = window.start;
+        pass.max_elevation = previous.elevation;
+    }
+
+    while (previous.time < window.duration)
+    {
+        /*
+         * the satellite cannot reach the minimum elevation, or leave it,
+         * within the least time
+         */
+        Sample next;
+        if (!Look(window, satellite, station, params, std::min(
+                        previous.time + kMinStep + LeastTime(reach, previous),
+                        window.duration), next))
+        {
+            break;
+        }
+
+        const bool next_up = next.elevation >= mask;
+        double aos = previous.time;
+        double los = next.time;
+
+        if (!up && next_up)
+        {
+            if (!FindRoot(elevation, previous.time,
+                        previous.elevation - mask, next.time,
+                        next.elevation - mask, aos))
+            {
+                return;
+            }
+            pass.aos = window.start.AddSeconds(aos);
+            pass.max_time = pass.aos;
+            pass.max_elevation = mask;
+        }
+        else if (up && !next_up)
+        {
+            if (!FindRoot(elevation, previous.time,
+                        previous.elevation - mask, next.time,
+                        next.elevation - mask, los))
+            {
+                return;
+            }
+        }
+
+        if (up || next_up)
+        {
+            /*
+             * the highest point is where the rate turns from rising to
+             * falling, or the end of the search
+             */
+            Sample highest = next;
+            if (previous.rate > 0.0 && next.rate <= 0.0)
+            {
+                double time;
+                if (!FindRoot(rate, previous.time, previous.rate,
+                            next.time, next.rate, time)
+                        || !Look(window, satellite, station, params,
+                            time, highest))
+                {
+                    return;
+                }
+            }
+            if (highest.time >= aos && highest.time <= los
+                    && highest.elevation > pass.max_elevation)
+            {
+                pass.max_time = window.start.AddSeconds(highest.time);
+                pass.max_elevation = highest.elevation;
+            }
+        }
+
+        if (up && !next_up)
+        {
+            pass.los = window.start.AddSeconds(los);
+            passes.push_back(pass);
+        }
+
+        up = next_up;
+        previous = next;
+    }
+
+    if (up)
+    {
+        /*
+         * still in view at the end of the search, or when propagation
+         * failed
+         */
+        pass.los = window.start.AddSeconds(previous.time);
+        passes.push_back(pass);
+    }
+}
+
+/*
+ * Least time for a satellite to reach the minimum elevation from a
+ * sample, rising or falling
+ */
+double PassPredictor::LeastTime(const Reach& reach, const Sample& sample)
+{
+    /*
+     * the height of the satellite above the cone of the minimum elevation
+     * and its rate, which changes no faster than the acceleration bounds
+     */
+    const double sinel = sin(sample.elevation);
+    const double height = sample.range * (sinel - reach.sinmask);
+    const double climb = sample.range_rate * (sinel - reach.sinmask)
+        + sample.range * sample.rate;
+
+    double time;
+    if (height < 0.0)
+    {
+        time = (sqrt(climb * climb - 2.0 * reach.rising * height) - climb)
+            / reach.rising;
+    }
+    else
+    {
+        time = (sqrt(climb * climb + 2.0 * reach.falling * height) + climb)
+            / reach.falling;
+    }
+
+    /*
+     * at any elevation the satellite is at least as far as the sphere of
+     * its perigee along the line of sight, nearer for higher elevations,
+     * and its elevation changes no faster than its speed over that range
+     */
+    const double high = std::max(sample.elevation, reach.mask);
+    const double sinhigh = sin(high);
+    const double nearest = kRangeMargin * std::max(1.0,
+            sqrt(std::max(0.0, reach.perigee * reach.perigee
+                    - reach.radius * reach.radius * (1.0 - sinhigh * sinhigh)))
+            - reach.radius * sinhigh);
+
+    time = std::max(time,
+            fabs(sample.elevation - reach.mask) * nearest / reach.speed);
+    if (sample.elevation < reach.mask)
+    {
+        /*
+         * it must also close to max_range before it can be seen
+         */
+        time = std::max(time,
+                (sample.range - reach.max_range) / reach.speed);
+
+        /*
+         * and move around its orbit to the band of latitudes the station
+         * can see. The sine of the latitude is the sine of the inclination
+         * times that of the argument of latitude, which is found from the
+         * latitude and the direction of travel
+         */
+        if (reach.band > 0.0 && reach.side * sample.latitude < reach.band)
+        {
+            const double current = asin(std::max(-1.0, std::min(1.0,
+                            sin(reach.side * sample.latitude)
+                            / reach.sin_inclination)));
+            const double target = asin(std::min(1.0,
+                        sin(reach.band) / reach.sin_inclination));
+            double angle = (sample.northward == (reach.side > 0.0))
+                ? target - current
+                : target + current + kPI;
+            if (angle < 0.0)
+            {
+                angle += kTWOPI;
+            }
+            time = std::max(time, angle / reach.angular_rate);
+        }
+    }
+    return time;
+}
+
+/*
+ * Elevation of a satellite over a station
+ * @returns false if the propagation fails
+ */
+bool PassPredictor::Look(
+        const Window& window,
+        const size_t satellite,
+        const size_t station,
+        SGP4::IntegratorParams& params,
+        const double time,
+        Sample& sample) const
+{
+    Eci eci(window.start, Vector());
+    if (models_[satellite].TryFindPosition(
+                window.offset[satellite] + time / 60.0, params, eci)
+            != SGP4::kOk)
+    {
+        return false;
+    }
+
+    /*
+     * rotate into the earth fixed frame
+     */
+    const double theta = window.gmst + kEarthRate * time;
+    const double sintheta = sin(theta);
+    const double costheta = cos(theta);
+    const Vector pos = eci.Position();
+    const Vector vel = eci.Velocity();
+    const double x = costheta * pos.x + sintheta * pos.y;
+    const double y = -sintheta * pos.x + costheta * pos.y;
+
+    const Station& st = stations_[station];
+    const double range[3] = {
+        x - st.position[0],
+        y - st.position[1],
+        pos.z - st.position[2]
+    };
+    const double rate[3] = {
+        costheta * vel.x + sintheta * vel.y + kEarthRate * y,
+        -sintheta * vel.x + costheta * vel.y - kEarthRate * x,
+        vel.z
+    };
+
+    const double range_sq = range[0] * range[0] + range[1] * range[1]
+        + range[2] * range[2];
+    const double distance = sqrt(range_sq);
+    const double height = range[0] * st.up[0] + range[1] * st.up[1]
+        + range[2] * st.up[2];
+    const double climb = rate[0] * st.up[0] + rate[1] * st.up[1]
+        + rate[2] * st.up[2];
+    const double closing = range[0] * rate[0] + range[1] * rate[1]
+        + range[2] * rate[2];
+
+    sample.time = time;
+    sample.elevation = asin(height / distance);
+    sample.rate = (climb - height * closing / range_sq) / distance;
+    sample.range = distance;
+    sample.range_rate = closing / distance;
+    sample.latitude = asin(pos.z / sqrt(x * x + y * y + pos.z * pos.z));
+    sample.northward = vel.z > 0.0;
+    return true;
+}
@@ -0,0 +1,236 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef PASSPREDICTOR_H_
+#define PASSPREDICTOR_H_
+
+#include "SGP4.h"
+#include "ThreadPool.h"
+#include "Tle.h"
+#include "CoordGeodetic.h"
+#include "DateTime.h"
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief A pass of a satellite over a station.
+ */
+struct Pass
+{
+    /*
+     * the indices of the satellite and the station
+     */
+    size_t satellite;
+    size_t station;
+    /*
+     * acquisition and loss of signal, the start or end of the search
+     * where the satellite is already or still up
+     */
+    DateTime aos;
+    DateTime los;
+    /*
+     * the time and the elevation in radians of the highest point
+     */
+    DateTime max_time;
+    double max_elevation;
+};
+
+/**
+ * @brief Finds the passes of many satellites over many stations.
+ *
+ * Each satellite is stepped across the search period separately for each
+ * station. Steps are kept within the least time the satellite could take
+ * to reach or leave the minimum elevation, so that no pass is stepped
+ * over. That time is bounded from the perigee, apogee, speed and
+ * acceleration of the orbit: the height above the minimum elevation
+ * changes no faster than its rate and the acceleration allow, the
+ * satellite must close to the range at which it can be seen, and must
+ * move around its orbit to the latitudes it can be seen from. A
+ * satellite far below the horizon is stepped a good part of its period at
+ * once, and pairs where a near earth orbit never reaches the latitudes
+ * seen from the station are not stepped at all. Acquisition and loss of
+ * signal are the roots of the elevation, and the highest point the root
+ * of its rate, found by Brent's method.
+ *
+ * Satellite and station pairs are searched in parallel across the
+ * threads of a ThreadPool. A PassPredictor must only be used by one
+ * thread at a time.
+ */
+class PassPredictor
+{
+public:
+    PassPredictor(
+            const std::vector<Tle>& tles,
+            const std::vector<CoordGeodetic>& stations,
+            ThreadPool& pool);
+
+    virtual ~PassPredictor()
+    {
+    }
+
+    std::vector<Pass> FindPasses(
+            const DateTime& start,
+            const DateTime& end,
+            const double min_elevation = 0.0) const;
+
+private:
+    struct Satellite
+    {
+        /*
+         * the index of the satellite
+         */
+        size_t index;
+        DateTime epoch;
+        /*
+         * the least perigee and greatest apogee radius in kilometers, and
+         * the greatest speed relative to the earth in kilometers per
+         * second
+         */
+        double perigee;
+        double apogee;
+        double speed;
+        /*
+         * the greatest latitude reached, widened for the perturbations of
+         * the orbit and a right angle for deep space orbits, and the
+         * fastest the satellite moves around its orbit in radians per
+         * second
+         */
+        double inclination;
+        double angular_rate;
+        /*
+         * the greatest acceleration relative to the earth in kilometers
+         * per second squared
+         */
+        double acceleration;
+    };
+
+    struct Station
+    {
+        /*
+         * earth fixed position in kilometers, and the unit vector up
+         */
+        double position[3];
+        double up[3];
+        /*
+         * the distance from the centre of the earth in kilometers, and the
+         * geocentric latitude
+         */
+        double radius;
+        double latitude;
+    };
+
+    /*
+     * the search period, times in seconds from its start
+     */
+    struct Window
+    {
+        DateTime start;
+        double duration;
+        double min_elevation;
+        /*
+         * Greenwich sidereal time at the start
+         */
+        double gmst;
+        /*
+         * minutes from the epoch of each satellite to the start
+         */
+        std::vector<double> offset;
+    };
+
+    /*
+     * what bounds the motion of a satellite over a station
+     */
+    struct Reach
+    {
+        /*
+         * the minimum elevation and its sine
+         */
+        double mask;
+        double sinmask;
+        /*
+         * the distance of the station from the centre of the earth, the
+         * least perigee radius and the greatest speed of the satellite
+         */
+        double radius;
+        double perigee;
+        double speed;
+        /*
+         * the furthest the satellite can be when at the minimum elevation
+         */
+        double max_range;
+        /*
+         * the fastest the height of the satellite above the cone of the
+         * minimum elevation can speed up rising, and falling, in
+         * kilometers per second squared
+         */
+        double rising;
+        double falling;
+        /*
+         * the latitude the satellite must reach towards the side of the
+         * equator of the station, or zero if none, 1 for a station north
+         * of the equator and -1 for south, the sine of the greatest
+         * latitude the satellite reaches, and the fastest it moves around
+         * its orbit in radians per second
+         */
+        double band;
+        double side;
+        double sin_inclination;
+        double angular_rate;
+    };
+
+    /*
+     * the elevation of a satellite over a station at one time, the rate
+     * of change of its sine, the range in kilometers and its rate, and
+     * the geocentric latitude of the satellite and whether it is heading
+     * north
+     */
+    struct Sample
+    {
+        double time;
+        double elevation;
+        double rate;
+        double range;
+        double range_rate;
+        double latitude;
+        bool northward;
+    };
+
+    void FindPasses(
+            const Window& window,
+            const size_t satellite,
+            const size_t station,
+            std::vector<Pass>& passes) const;
+    static double LeastTime(const Reach& reach, const Sample& sample);
+    bool Look(
+            const Window& window,
+            const size_t satellite,
+            const size_t station,
+            SGP4::IntegratorParams& params,
+            const double time,
+            Sample& sample) const;
+
+    ThreadPool& pool_;
+    /*
+     * the satellites that could be initialised and their models
+     */
+    std::vector<Satellite> satellites_;
+    std::vector<SGP4> models_;
+    std::vector<Station> stations_;
+};
+
+#endif
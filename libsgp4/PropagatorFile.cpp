@@ -0,0 +1,461 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "PropagatorFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdint.h>
+
+namespace
+{
+    static const char kMagic[8] = { 'S', 'G', 'P', '4', 'P', 'R', 'O', 'P' };
+    static const uint32_t kVersion = 2;
+
+    static const size_t kHeaderSize = 32;
+    static const size_t kRecordHeaderSize = 24;
+    /*
+     * the most constants held by one record
+     */
+    static const size_t kMaxConstants = 96;
+
+    static const uint32_t kFlagSimpleModel = 1;
+    static const uint32_t kFlagDeepSpace = 2;
+    static const uint32_t kFlagResonance = 4;
+    static const uint32_t kFlagSynchronous = 8;
+
+    /*
+     * values are stored little endian, which on little endian machines
+     * is a plain copy
+     */
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    inline uint64_t ReadUInt64(const char* p)
+    {
+        uint64_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline uint32_t ReadUInt32(const char* p)
+    {
+        uint32_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+#else
+    inline uint64_t ReadUInt64(const char* p)
+    {
+        uint64_t value = 0;
+        for (int i = 7; i >= 0; i--)
+        {
+            value = (value << 8) | static_cast<unsigned char>(p[i]);
+        }
+        return value;
+    }
+
+    inline uint32_t ReadUInt32(const char* p)
+    {
+        uint32_t value = 0;
+        for (int i = 3; i >= 0; i--)
+        {
+            value = (value << 8) | static_cast<unsigned char>(p[i]);
+        }
+        return value;
+    }
+#endif
+
+    inline double ReadDouble(const char* p)
+    {
+        const uint64_t bits = ReadUInt64(p);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    inline void AppendUInt64(std::string& out, const uint64_t value)
+    {
+        for (int i = 0; i < 8; i++)
+        {
+            out += static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+    }
+
+    inline void AppendUInt32(std::string& out, const uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            out += static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+    }
+
+    inline void AppendDouble(std::string& out, const double value)
+    {
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        AppendUInt64(out, bits);
+    }
+}
+
+/**
+ * Map a file written by Write() and check its structure
+ * @param[in] filename the file
+ * @exception SatelliteException if the file cannot be read or is not a
+ * valid propagator file
+ */
+PropagatorFile::PropagatorFile(const std::string& filename)
+    : size_(0)
+{
+    if (!file_.Map(filename))
+    {
+        std::string err = "Failed to read " + filename;
+        throw SatelliteException(err.c_str());
+    }
+
+    const char* data = file_.Data();
+    const size_t length = file_.Length();
+
+    if (length < kHeaderSize || memcmp(data, kMagic, sizeof(kMagic)) != 0)
+    {
+        throw SatelliteException("Not a propagator file");
+    }
+
+    if (ReadUInt32(data + 8) != kVersion)
+    {
+        throw SatelliteException("Unsupported propagator file version");
+    }
+
+    if (ReadUInt32(data + 12) != Wgs72::kId)
+    {
+        throw SatelliteException(
+                "Propagator file written for another gravity model");
+    }
+
+    const uint64_t count = ReadUInt64(data + 16);
+    if (count > (length - kHeaderSize) / 8)
+    {
+        throw SatelliteException("Truncated propagator file");
+    }
+    size_ = static_cast<size_t>(count);
+
+    /*
+     * check every record lies within the file, so that Model() need not
+     */
+    SGP4 model;
+    double* fields[kMaxConstants];
+    model.use_deep_space_ = false;
+    const size_t near_constants = Constants(model, fields);
+    model.use_deep_space_ = true;
+    model.deepspace_ = std::make_shared<SGP4::DeepSpaceState>();
+    const size_t deep_constants = Constants(model, fields);
+
+    for (size_t i = 0; i < size_; i++)
+    {
+        const uint64_t offset = ReadUInt64(data + kHeaderSize + 8 * i);
+        if (offset % 8 != 0 || offset > length - kRecordHeaderSize)
+        {
+            throw SatelliteException("Truncated propagator file");
+        }
+
+        const char* record = data + offset;
+        const uint32_t constants = ReadUInt32(record + 20);
+        if (constants > kMaxConstants
+                || constants > (length - offset - kRecordHeaderSize) / 8)
+        {
+            throw SatelliteException("Truncated propagator file");
+        }
+
+        const bool deep = (ReadUInt32(record + 16) & kFlagDeepSpace) != 0;
+        if (constants != (deep ? deep_constants : near_constants))
+        {
+            throw SatelliteException("Invalid propagator file record");
+        }
+    }
+}
+
+/**
+ * @param[in] i the index of the record
+ * @returns the norad number of the satellite
+ */
+unsigned long PropagatorFile::NoradNumber(const size_t i) const
+{
+    return static_cast<unsigned long>(ReadUInt64(Record(i)));
+}
+
+/**
+ * Restore a model from the file, without initialising it again
+ * @param[in] i the index of the record
+ * @returns the model, identical to one constructed from the tle
+ */
+SGP4 PropagatorFile::Model(const size_t i) const
+{
+    const char* record = Record(i);
+    const uint32_t flags = ReadUInt32(record + 16);
+
+    SGP4 model;
+    model.use_simple_model_ = (flags & kFlagSimpleModel) != 0;
+    model.use_deep_space_ = (flags & kFlagDeepSpace) != 0;
+    if (model.use_deep_space_)
+    {
+        model.deepspace_ = std::make_shared<SGP4::DeepSpaceState>();
+        model.deepspace_->consts.resonance_flag
+            = (flags & kFlagResonance) != 0;
+        model.deepspace_->consts.synchronous_flag
+            = (flags & kFlagSynchronous) != 0;
+        model.integrator_params_ = SGP4::Empty_IntegratorParams;
+    }
+    model.elements_.epoch_ = DateTime(
+            static_cast<long long>(ReadUInt64(record + 8)));
+
+    double* constants[kMaxConstants];
+    const size_t count = Constants(model, constants);
+    const char* values = record + kRecordHeaderSize;
+    for (size_t k = 0; k < count; k++)
+    {
+        *constants[k] = ReadDouble(values + 8 * k);
+    }
+
+    /*
+     * the integrator starts from epoch, as left by
+     * SGP4::DeepSpaceInitialise()
+     */
+    if (model.use_deep_space_ && model.deepspace_->consts.resonance_flag)
+    {
+        model.integrator_params_.atime = 0.0;
+        model.integrator_params_.xni
+            = model.elements_.RecoveredMeanMotion();
+        model.integrator_params_.xli
+            = model.deepspace_->integrator_consts.xlamo;
+    }
+
+    return model;
+}
+
+/**
+ * Initialise a model for each tle and write them to a file. A tle which
+ * cannot be initialised is left out, the rest keeping their order.
+ * @param[in] filename the file to write
+ * @param[in] tles the satellites, in the order they are to be stored
+ * @returns the indices of the tles left out
+ * @exception SatelliteException if the file cannot be written
+ */
+std::vector<size_t> PropagatorFile::Write(
+        const std::string& filename,
+        const std::vector<Tle>& tles)
+{
+    std::vector<SGP4> models;
+    std::vector<unsigned long> norad_numbers;
+    std::vector<size_t> skipped;
+    models.reserve(tles.size());
+    norad_numbers.reserve(tles.size());
+    for (size_t i = 0; i < tles.size(); i++)
+    {
+        try
+        {
+            models.push_back(SGP4(tles[i]));
+            norad_numbers.push_back(tles[i].NoradNumber());
+        }
+        catch (SatelliteException&)
+        {
+            skipped.push_back(i);
+        }
+    }
+
+    std::ofstream out(filename.c_str(), std::ios::out | std::ios::binary);
+    if (!out)
+    {
+        std::string err = "Failed to write " + filename;
+        throw SatelliteException(err.c_str());
+    }
+
+    std::string buffer(kMagic, sizeof(kMagic));
+    AppendUInt32(buffer, kVersion);
+    AppendUInt32(buffer, Wgs72::kId);
+    AppendUInt64(buffer, models.size());
+    AppendUInt64(buffer, 0);
+
+    double* constants[kMaxConstants];
+    uint64_t offset = kHeaderSize + 8 * models.size();
+    for (size_t i = 0; i < models.size(); i++)
+    {
+        AppendUInt64(buffer, offset);
+        offset += kRecordHeaderSize + 8 * Constants(models[i], constants);
+    }
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+
+    for (size_t i = 0; i < models.size(); i++)
+    {
+        SGP4& model = models[i];
+
+        uint32_t flags = 0;
+        flags |= model.use_simple_model_ ? kFlagSimpleModel : 0;
+        if (model.use_deep_space_)
+        {
+            const SGP4::DeepSpaceConstants& deepspace
+                = model.deepspace_->consts;
+            flags |= kFlagDeepSpace;
+            flags |= deepspace.resonance_flag ? kFlagResonance : 0;
+            flags |= deepspace.synchronous_flag ? kFlagSynchronous : 0;
+        }
+
+        const size_t count = Constants(model, constants);
+
+        buffer.clear();
+        AppendUInt64(buffer, norad_numbers[i]);
+        AppendUInt64(buffer,
+                static_cast<uint64_t>(model.elements_.Epoch().Ticks()));
+        AppendUInt32(buffer, flags);
+        AppendUInt32(buffer, static_cast<uint32_t>(count));
+        for (size_t k = 0; k < count; k++)
+        {
+            AppendDouble(buffer, *constants[k]);
+        }
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+
+    out.close();
+    if (!out)
+    {
+        std::string err = "Failed to write " + filename;
+        throw SatelliteException(err.c_str());
+    }
+
+    return skipped;
+}
+
+const char* PropagatorFile::Record(const size_t i) const
+{
+    const char* data = file_.Data();
+    return data + ReadUInt64(data + kHeaderSize + 8 * i);
+}
+
+/**
+ * The constants stored for a model, in file order. Near earth models
+ * store the near space constants, deep space models the deep space and
+ * integrator constants.
+ * @param[in] model the model
+ * @param[out] constants a pointer to each constant of the model
+ * @returns the number of constants
+ */
+size_t PropagatorFile::Constants(SGP4& model, double** constants)
+{
+    size_t n = 0;
+
+    OrbitalElements& elements = model.elements_;
+    constants[n++] = &elements.mean_anomoly_;
+    constants[n++] = &elements.ascending_node_;
+    constants[n++] = &elements.argument_perigee_;
+    constants[n++] = &elements.eccentricity_;
+    constants[n++] = &elements.inclination_;
+    constants[n++] = &elements.mean_motion_;
+    constants[n++] = &elements.bstar_;
+    constants[n++] = &elements.recovered_semi_major_axis_;
+    constants[n++] = &elements.recovered_mean_motion_;
+    constants[n++] = &elements.perigee_;
+    constants[n++] = &elements.period_;
+
+    SGP4::CommonConstants& common = model.common_consts_;
+    constants[n++] = &common.cosio;
+    constants[n++] = &common.sinio;
+    constants[n++] = &common.eta;
+    constants[n++] = &common.t2cof;
+    constants[n++] = &common.a3ovk2;
+    constants[n++] = &common.x1mth2;
+    constants[n++] = &common.x3thm1;
+    constants[n++] = &common.x7thm1;
+    constants[n++] = &common.aycof;
+    constants[n++] = &common.xlcof;
+    constants[n++] = &common.xnodcf;
+    constants[n++] = &common.c1;
+    constants[n++] = &common.c4;
+    constants[n++] = &common.omgdot;
+    constants[n++] = &common.xnodot;
+    constants[n++] = &common.xmdot;
+
+    if (!model.use_deep_space_)
+    {
+        SGP4::NearSpaceConstants& nearspace = model.nearspace_consts_;
+        constants[n++] = &nearspace.c5;
+        constants[n++] = &nearspace.omgcof;
+        constants[n++] = &nearspace.xmcof;
+        constants[n++] = &nearspace.delmo;
+        constants[n++] = &nearspace.sinmo;
+        constants[n++] = &nearspace.d2;
+        constants[n++] = &nearspace.d3;
+        constants[n++] = &nearspace.d4;
+        constants[n++] = &nearspace.t3cof;
+        constants[n++] = &nearspace.t4cof;
+        constants[n++] = &nearspace.t5cof;
+        return n;
+    }
+
+    SGP4::DeepSpaceConstants& deepspace = model.deepspace_->consts;
+    constants[n++] = &deepspace.gsto;
+    constants[n++] = &deepspace.zmol;
+    constants[n++] = &deepspace.zmos;
+    constants[n++] = &deepspace.sse;
+    constants[n++] = &deepspace.ssi;
+    constants[n++] = &deepspace.ssl;
+    constants[n++] = &deepspace.ssg;
+    constants[n++] = &deepspace.ssh;
+    constants[n++] = &deepspace.se2;
+    constants[n++] = &deepspace.si2;
+    constants[n++] = &deepspace.sl2;
+    constants[n++] = &deepspace.sgh2;
+    constants[n++] = &deepspace.sh2;
+    constants[n++] = &deepspace.se3;
+    constants[n++] = &deepspace.si3;
+    constants[n++] = &deepspace.sl3;
+    constants[n++] = &deepspace.sgh3;
+    constants[n++] = &deepspace.sh3;
+    constants[n++] = &deepspace.sl4;
+    constants[n++] = &deepspace.sgh4;
+    constants[n++] = &deepspace.ee2;
+    constants[n++] = &deepspace.e3;
+    constants[n++] = &deepspace.xi2;
+    constants[n++] = &deepspace.xi3;
+    constants[n++] = &deepspace.xl2;
+    constants[n++] = &deepspace.xl3;
+    constants[n++] = &deepspace.xl4;
+    constants[n++] = &deepspace.xgh2;
+    constants[n++] = &deepspace.xgh3;
+    constants[n++] = &deepspace.xgh4;
+    constants[n++] = &deepspace.xh2;
+    constants[n++] = &deepspace.xh3;
+    constants[n++] = &deepspace.d2201;
+    constants[n++] = &deepspace.d2211;
+    constants[n++] = &deepspace.d3210;
+    constants[n++] = &deepspace.d3222;
+    constants[n++] = &deepspace.d4410;
+    constants[n++] = &deepspace.d4422;
+    constants[n++] = &deepspace.d5220;
+    constants[n++] = &deepspace.d5232;
+    constants[n++] = &deepspace.d5421;
+    constants[n++] = &deepspace.d5433;
+    constants[n++] = &deepspace.del1;
+    constants[n++] = &deepspace.del2;
+    constants[n++] = &deepspace.del3;
+
+    SGP4::IntegratorConstants& integrator
+        = model.deepspace_->integrator_consts;
+    constants[n++] = &integrator.xfact;
+    constants[n++] = &integrator.xlamo;
+    constants[n++] = &integrator.values_0.xndot;
+    constants[n++] = &integrator.values_0.xnddt;
+    constants[n++] = &integrator.values_0.xldot;
+
+    return n;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef PROPAGATORFILE_H_
+#define PROPAGATORFILE_H_
+
+#include "SGP4.h"
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A file of initialised SGP4 models.
+ *
+ * Holds the orbital elements and every constant computed by
+ * SGP4::Initialise() for each satellite, so that models can be restored
+ * without repeating the initialisation. The file is mapped into memory
+ * and each model is decoded only when it is asked for. The constants
+ * depend on the gravity model, so the file records the one it was
+ * written with, Wgs72 as used by SGP4.
+ *
+ * Layout, with every value little endian:
+ *
+ * header, 32 bytes
+ * - 8 bytes, "SGP4PROP"
+ * - uint32, format version
+ * - uint32, gravity model, the kId of Wgs72
+ * - uint64, number of records
+ * - uint64, zero
+ *
+ * record offsets
+ * - uint64 per record, from the start of the file
+ *
+ * records, each at a multiple of 8 bytes
+ * - uint64, norad number
+ * - int64, epoch in DateTime ticks
+ * - uint32, flags (simple model, deep space, resonance, synchronous)
+ * - uint32, number of constants
+ * - float64 per constant, the near earth or the deep space set
+ */
+class PropagatorFile
+{
+public:
+    PropagatorFile(const std::string& filename);
+
+    virtual ~PropagatorFile()
+    {
+    }
+
+    /**
+     * @returns the number of models in the file
+     */
+    size_t Size() const
+    {
+        return size_;
+    }
+
+    unsigned long NoradNumber(const size_t i) const;
+    SGP4 Model(const size_t i) const;
+
+    static std::vector<size_t> Write(
+            const std::string& filename,
+            const std::vector<Tle>& tles);
+
+private:
+    PropagatorFile(const PropagatorFile&);
+    PropagatorFile& operator=(const PropagatorFile&);
+
+    const char* Record(const size_t i) const;
+    static size_t Constants(SGP4& model, double** constants);
+
+    MappedFile file_;
+    size_t size_;
+};
+
+#endif
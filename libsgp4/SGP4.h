@@ -19,11 +19,20 @@
 #define SGP4_H_
 
 #include "Tle.h"
+#include "Gravity.h"
 #include "OrbitalElements.h"
 #include "Eci.h"
 #include "SatelliteException.h"
 #include "DecayedException.h"
 
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+struct NearSpaceView;
+template <typename Gravity> class SGP4BatchModel;
+
 /**
  * @mainpage
  *
@@ -31,26 +40,124 @@
  */
 
 /**
- * @brief The simplified perturbations model 4 propagater.
+ * @brief The state of an SGP4 propagator, and the parts of it which do
+ * not depend on the gravity model.
  */
-class SGP4
+class SGP4Base
 {
 public:
-    SGP4(const Tle& tle)
-        : elements_(tle)
+    struct IntegratorValues
+    {
+        double xndot;
+        double xnddt;
+        double xldot;
+    };
+
+    /**
+     * @brief State of the deep space resonance integrator.
+     *
+     * Propagating a resonant deep space satellite steps this state from
+     * epoch towards the requested time. A value initialised instance,
+     * IntegratorParams(), starts from epoch. Keeping one per thread lets
+     * threads share a single SGP4 through the FindPosition() overloads
+     * taking an IntegratorParams.
+     */
+    struct IntegratorParams
+    {
+        /*
+         * integrator values
+         */
+        double xli;
+        double xni;
+        double atime;
+        /*
+         * itegrator values for current d_atime_
+         */
+        struct IntegratorValues values_t;
+    };
+
+    /**
+     * @brief The outcome of propagating to one time.
+     *
+     * Returned by the TryFindPosition() functions in place of the
+     * exceptions thrown by FindPosition().
+     */
+    enum Status
+    {
+        kOk = 0,
+        /*
+         * the perturbed eccentricity fell below -0.001
+         */
+        kEccentricity,
+        /*
+         * the long period eccentricity squared reached 1
+         */
+        kElsq,
+        /*
+         * the semi-latus rectum is negative
+         */
+        kSemiLatusRectum,
+        /*
+         * the satellite is below the surface of the earth, the position
+         * and velocity are still given
+         */
+        kDecayed,
+        /*
+         * the deep space mean motion is not positive
+         */
+        kMeanMotion,
+        /*
+         * the elements could not be initialised, only reported by
+         * callers holding a tle rather than a model
+         */
+        kInvalidElements
+    };
+
+    /**
+     * The checkpoints kept by default where a model is propagated to
+     * arbitrary times over many calls, as in SGP4Batch
+     */
+    static const size_t kDefaultIntegratorCheckpoints = 256;
+
+    /**
+     * How far the short periodic terms can take a satellite outside the
+     * shell between the perigee and apogee of its mean elements, in
+     * kilometers
+     */
+    static constexpr double kApsisMargin = 50.0;
+
+    virtual ~SGP4Base()
     {
-        Initialise();
     }
 
-    virtual ~SGP4()
+    static bool UsesDeepSpace(const OrbitalElements& elements);
+
+    /**
+     * @returns whether the satellite is propagated with the deep space
+     * model
+     */
+    bool UsesDeepSpace() const
     {
+        return use_deep_space_;
     }
 
-    void SetTle(const Tle& tle);
-    Eci FindPosition(double tsince) const;
-    Eci FindPosition(const DateTime& date) const;
+    void SetIntegratorCheckpoints(const size_t max_checkpoints);
+
+protected:
+    template <typename> friend class SGP4BatchModel;
+    friend class PropagatorFile;
+    friend class ChebyshevEphemeris;
+
+    SGP4Base()
+    {
+        Reset();
+    }
+
+    SGP4Base(const OrbitalElements& elements)
+        : elements_(elements)
+    {
+    }
 
-private:
     struct CommonConstants
     {
         double cosio;
@@ -78,6 +185,10 @@ private:
         double xmcof;
         double delmo;
         double sinmo;
+        /*
+         * left at zero for satellites using the simple model, which
+         * carry them unused
+         */
         double d2;
         double d3;
         double d4;
@@ -156,13 +267,6 @@ private:
         double del3;
     };
 
-    struct IntegratorValues
-    {
-        double xndot;
-        double xnddt;
-        double xldot;
-    };
-
     struct IntegratorConstants
     {
         /*
@@ -176,39 +280,14 @@ private:
          */
         struct IntegratorValues values_0;
     };
-
-    struct IntegratorParams
-    {
-        /*
-         * integrator values
-         */
-        double xli;
-        double xni;
-        double atime;
-        /*
-         * itegrator values for current d_atime_
-         */
-        struct IntegratorValues values_t;
-    };
     
-    void Initialise();
-    Eci FindPositionSDP4(const double tsince) const;
-    Eci FindPositionSGP4(double tsince) const;
-    Eci CalculateFinalPositionVelocity(
-            const double tsince,
-            const double e,
-            const double a,
-            const double omega,
-            const double xl,
-            const double xnode,
-            const double xincl,
-            const double xlcof,
-            const double aycof,
-            const double x3thm1,
-            const double x1mth2,
-            const double x7thm1,
-            const double cosio,
-            const double sinio) const;
+    /*
+     * doubles written by NearSpace(), the constants of the kernel view
+     * which are not stored in the model
+     */
+    static const size_t kNearSpaceValues = 9;
+
+    void NearSpace(NearSpaceView& view, double* values) const;
     void DeepSpaceInitialise(
             const double eosq,
             const double sinio,
@@ -235,18 +314,27 @@ private:
             double& xll) const;
     void DeepSpaceSecular(
             const double tsince,
+            IntegratorParams& params,
             double& xll,
             double& omgasm,
             double& xnodes,
             double& em,
             double& xinc,
             double& xn) const;
-    void DeepSpaceCalcDotTerms(struct IntegratorValues& values) const;
+    void DeepSpaceCalcDotTerms(
+            const IntegratorParams& params,
+            struct IntegratorValues& values) const;
     void DeepSpaceIntegrator(
+            IntegratorParams& params,
             const double delt,
             const double step2,
             const struct IntegratorValues& values) const;
+    IntegratorParams DeepSpaceCheckpoint(
+            const double tsince,
+            const double step,
+            const double step2) const;
     void Reset();
+    static void ThrowError(const Status status, const Eci& eci);
 
     /*
      * flags
@@ -255,24 +343,180 @@ private:
     bool use_deep_space_;
 
     /*
-     * the constants used
+     * integrator states at multiples of the integrator step, built on
+     * demand
+     */
+    struct IntegratorCheckpoints
+    {
+        IntegratorCheckpoints(const size_t max_checkpoints)
+            : capacity(max_checkpoints),
+              interval(1)
+        {
+        }
+
+        std::mutex mutex;
+        /*
+         * the most checkpoints kept in each direction
+         */
+        size_t capacity;
+        /*
+         * integrator steps between checkpoints, doubled whenever a
+         * direction fills up
+         */
+        size_t interval;
+        /*
+         * checkpoint i is the state after i * interval steps away from
+         * epoch, forwards or backwards in time
+         */
+        std::vector<IntegratorParams> forward;
+        std::vector<IntegratorParams> backward;
+    };
+
+    /*
+     * the state only deep space satellites use, held on the heap so that
+     * near earth models do not carry it. Copies of the model share it;
+     * once initialised only the checkpoints change, under their mutex
+     */
+    struct DeepSpaceState
+    {
+        struct DeepSpaceConstants consts;
+        struct IntegratorConstants integrator_consts;
+        std::shared_ptr<IntegratorCheckpoints> checkpoints;
+    };
+
+    /*
+     * the constants used. Near earth satellites use nearspace_consts_,
+     * deep space satellites deepspace_ and integrator_params_. Only the
+     * deep space state is kept out of near earth models; the union is as
+     * large as nearspace_consts_ whichever model is used
      */
     struct CommonConstants common_consts_;
-    struct NearSpaceConstants nearspace_consts_;
-    struct DeepSpaceConstants deepspace_consts_;
-    struct IntegratorConstants integrator_consts_;
-    mutable struct IntegratorParams integrator_params_;
+    union
+    {
+        struct NearSpaceConstants nearspace_consts_;
+        mutable struct IntegratorParams integrator_params_;
+    };
+    std::shared_ptr<DeepSpaceState> deepspace_;
 
     /*
      * the orbit data
      */
     OrbitalElements elements_;
 
-    static const struct SGP4::CommonConstants Empty_CommonConstants;
-    static const struct SGP4::NearSpaceConstants Empty_NearSpaceConstants;
-    static const struct SGP4::DeepSpaceConstants Empty_DeepSpaceConstants;
-    static const struct SGP4::IntegratorConstants Empty_IntegratorConstants;
-    static const struct SGP4::IntegratorParams Empty_IntegratorParams;
+    static const struct SGP4Base::CommonConstants Empty_CommonConstants;
+    static const struct SGP4Base::NearSpaceConstants Empty_NearSpaceConstants;
+    static const struct SGP4Base::IntegratorParams Empty_IntegratorParams;
 };
 
+/**
+ * @brief The simplified perturbations model 4 propagater.
+ *
+ * The gravity model is a template argument, one of the models in
+ * Gravity.h, whose constants are folded into the propagation code; the
+ * library is built for each of them. SGP4 uses Wgs72, the model the
+ * published element sets are generated with.
+ */
+template <typename Gravity>
+class SGP4Model : public SGP4Base
+{
+public:
+    SGP4Model(const Tle& tle)
+        : SGP4Base(OrbitalElements(tle, Gravity()))
+    {
+        Initialise();
+    }
+
+    virtual ~SGP4Model()
+    {
+    }
+
+    void SetTle(const Tle& tle);
+    Eci FindPosition(double tsince) const;
+    Eci FindPosition(const DateTime& date) const;
+    Eci FindPosition(double tsince, IntegratorParams& params) const;
+    Eci FindPosition(const DateTime& date, IntegratorParams& params) const;
+    void FindPositions(
+            const double* tsince,
+            const size_t count,
+            Eci* out) const;
+    void FindPositions(
+            const double* tsince,
+            const size_t count,
+            double* position,
+            double* velocity) const;
+    Status TryFindPosition(double tsince, Eci& eci) const;
+    Status TryFindPosition(const DateTime& date, Eci& eci) const;
+    Status TryFindPosition(
+            double tsince,
+            IntegratorParams& params,
+            Eci& eci) const;
+    Status TryFindPosition(
+            const DateTime& date,
+            IntegratorParams& params,
+            Eci& eci) const;
+    void TryFindPositions(
+            const double* tsince,
+            const size_t count,
+            Eci* out,
+            Status* status) const;
+    void TryFindPositions(
+            const double* tsince,
+            const size_t count,
+            double* position,
+            double* velocity,
+            Status* status) const;
+    void TryFindPositions(
+            const double* tsince,
+            const size_t count,
+            float* position,
+            float* velocity,
+            Status* status) const;
+
+private:
+    template <typename> friend class SGP4BatchModel;
+    friend class PropagatorFile;
+
+    /*
+     * an empty model, for PropagatorFile to fill in
+     */
+    SGP4Model()
+    {
+    }
+
+    void Initialise();
+    template <typename T, typename Kernel>
+    void Propagate(
+            const double* tsince,
+            const size_t count,
+            const Kernel kernel,
+            T* position,
+            T* velocity,
+            Status* status) const;
+    Status FindPositionSDP4(
+            const double tsince,
+            IntegratorParams& params,
+            const bool velocity,
+            Eci& eci) const;
+    Status FindPositionSGP4(double tsince, Eci& eci) const;
+    Status CalculateFinalPositionVelocity(
+            const double tsince,
+            const double e,
+            const double a,
+            const double omega,
+            const double xl,
+            const double xnode,
+            const double xincl,
+            const double xlcof,
+            const double aycof,
+            const double x3thm1,
+            const double x1mth2,
+            const double x7thm1,
+            const double cosio,
+            const double sinio,
+            const bool velocity,
+            Eci& eci) const;
+};
+
+typedef SGP4Model<Wgs72> SGP4;
+
 #endif
@@ -0,0 +1,434 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "SGP4Batch.h"
+
+#include "Globals.h"
+#include "SatelliteException.h"
+#include "DecayedException.h"
+#include "SimdKernels.h"
+
+#include <algorithm>
+
+/**
+ * @param[in] tles the satellites to add
+ */
+template <typename Gravity>
+SGP4BatchModel<Gravity>::SGP4BatchModel(const std::vector<Tle>& tles)
+{
+    for (size_t i = 0; i < tles.size(); i++)
+    {
+        Add(tles[i]);
+    }
+}
+
+/**
+ * Add a satellite to the batch
+ * @param[in] tle the satellite
+ * @returns the index of the satellite within the batch
+ * @exception SatelliteException if the tle cannot be initialised
+ */
+template <typename Gravity>
+size_t SGP4BatchModel<Gravity>::Add(const Tle& tle)
+{
+    return Add(SGP4Model<Gravity>(tle));
+}
+
+/**
+ * Add an initialised model to the batch
+ * @param[in] model the model
+ * @returns the index of the satellite within the batch
+ */
+template <typename Gravity>
+size_t SGP4BatchModel<Gravity>::Add(const SGP4Model<Gravity>& model)
+{
+    const size_t slot = Size();
+
+    if (model.use_deep_space_)
+    {
+        deep_.push_back(model);
+        deep_slots_.push_back(slot);
+
+        /*
+         * every call integrates afresh, from the nearest checkpoint
+         */
+        if (!model.deepspace_->checkpoints)
+        {
+            deep_.back().SetIntegratorCheckpoints(
+                    SGP4Base::kDefaultIntegratorCheckpoints);
+        }
+    }
+    else
+    {
+        AddNearSpace(model);
+        near_slots_.push_back(slot);
+    }
+
+    return slot;
+}
+
+/**
+ * Remove all satellites from the batch
+ */
+template <typename Gravity>
+void SGP4BatchModel<Gravity>::Clear()
+{
+    near_ = NearSpaceColumns();
+    near_slots_.clear();
+    deep_.clear();
+    deep_slots_.clear();
+}
+
+template <typename Gravity>
+void SGP4BatchModel<Gravity>::AddNearSpace(
+        const SGP4Model<Gravity>& model)
+{
+    const OrbitalElements& elements = model.elements_;
+    const SGP4::CommonConstants& common = model.common_consts_;
+    const SGP4::NearSpaceConstants& nearspace = model.nearspace_consts_;
+
+    near_.epoch.push_back(elements.Epoch().Ticks());
+    near_.xmo.push_back(elements.MeanAnomoly());
+    near_.omegao.push_back(elements.ArgumentPerigee());
+    near_.xnodeo.push_back(elements.AscendingNode());
+    near_.eo.push_back(elements.Eccentricity());
+    near_.aodp.push_back(elements.RecoveredSemiMajorAxis());
+    near_.xnodp.push_back(elements.RecoveredMeanMotion());
+
+    near_.cosio.push_back(common.cosio);
+    near_.sinio.push_back(common.sinio);
+    near_.eta.push_back(common.eta);
+    near_.t2cof.push_back(common.t2cof);
+    near_.x1mth2.push_back(common.x1mth2);
+    near_.x3thm1.push_back(common.x3thm1);
+    near_.x7thm1.push_back(common.x7thm1);
+    near_.aycof.push_back(common.aycof);
+    near_.xlcof.push_back(common.xlcof);
+    near_.xnodcf.push_back(common.xnodcf);
+    near_.c1.push_back(common.c1);
+    near_.bstarc4.push_back(elements.BStar() * common.c4);
+    near_.omgdot.push_back(common.omgdot);
+    near_.xnodot.push_back(common.xnodot);
+    near_.xmdot.push_back(common.xmdot);
+
+    if (model.use_simple_model_)
+    {
+        near_.bstarc5.push_back(0.0);
+        near_.omgcof.push_back(0.0);
+        near_.xmcof.push_back(0.0);
+        near_.delmo.push_back(0.0);
+        near_.sinmo.push_back(0.0);
+        near_.d2.push_back(0.0);
+        near_.d3.push_back(0.0);
+        near_.d4.push_back(0.0);
+        near_.t3cof.push_back(0.0);
+        near_.t4cof.push_back(0.0);
+        near_.t5cof.push_back(0.0);
+    }
+    else
+    {
+        near_.bstarc5.push_back(elements.BStar() * nearspace.c5);
+        near_.omgcof.push_back(nearspace.omgcof);
+        near_.xmcof.push_back(nearspace.xmcof);
+        near_.delmo.push_back(nearspace.delmo);
+        near_.sinmo.push_back(nearspace.sinmo);
+        near_.d2.push_back(nearspace.d2);
+        near_.d3.push_back(nearspace.d3);
+        near_.d4.push_back(nearspace.d4);
+        near_.t3cof.push_back(nearspace.t3cof);
+        near_.t4cof.push_back(nearspace.t4cof);
+        near_.t5cof.push_back(nearspace.t5cof);
+    }
+}
+
+/**
+ * Propagate every satellite in the batch to the given time
+ * @param[in] dt the time to propagate to
+ * @param[out] position 3 * Size() values, x y z in kilometers
+ * @param[out] velocity 3 * Size() values, x y z in kilometers per second,
+ * or NULL to compute positions only
+ * @exception SatelliteException on a propagation error
+ * @exception DecayedException if a satellite has decayed
+ */
+template <typename Gravity>
+void SGP4BatchModel<Gravity>::FindPositions(
+        const DateTime& dt,
+        double* position,
+        double* velocity) const
+{
+    FindPositions(dt, position, velocity, NULL);
+}
+
+/**
+ * Propagate every satellite in the batch to the given time, reporting
+ * the outcome for each satellite rather than throwing
+ * @param[in] dt the time to propagate to
+ * @param[out] position 3 * Size() values, x y z in kilometers
+ * @param[out] velocity 3 * Size() values, x y z in kilometers per second,
+ * or NULL to compute positions only
+ * @param[out] status Size() values, the outcome for each satellite.
+ * Position and velocity are zero unless it is SGP4::kOk or
+ * SGP4::kDecayed. If NULL the first failure throws as
+ * SGP4::FindPosition() would
+ */
+template <typename Gravity>
+void SGP4BatchModel<Gravity>::FindPositions(
+        const DateTime& dt,
+        double* position,
+        double* velocity,
+        SGP4::Status* status) const
+{
+    Propagate(dt, NearSpaceKernelsFor(SimdDispatch(), Gravity()).near_space,
+            position, velocity, status);
+}
+
+/**
+ * Propagate every satellite in the batch to the given time in single
+ * precision, with the accuracy of the single precision
+ * SGP4::TryFindPositions()
+ * @param[in] dt the time to propagate to
+ * @param[out] position 3 * Size() values, x y z in kilometers
+ * @param[out] velocity 3 * Size() values, x y z in kilometers per second,
+ * or NULL to compute positions only
+ * @param[out] status Size() values, the outcome for each satellite.
+ * Position and velocity are zero unless it is SGP4::kOk or
+ * SGP4::kDecayed. If NULL the first failure throws as
+ * SGP4::FindPosition() would
+ */
+template <typename Gravity>
+void SGP4BatchModel<Gravity>::FindPositions(
+        const DateTime& dt,
+        float* position,
+        float* velocity,
+        SGP4::Status* status) const
+{
+    Propagate(dt,
+            NearSpaceKernelsFor(SimdDispatch(), Gravity()).near_space_float,
+            position, velocity, status);
+}
+
+/*
+ * FindPositions() in the precision of T, using the near earth kernel
+ * writing T
+ */
+template <typename Gravity>
+template <typename T, typename Kernel>
+void SGP4BatchModel<Gravity>::Propagate(
+        const DateTime& dt,
+        const Kernel kernel,
+        T* position,
+        T* velocity,
+        SGP4::Status* status) const
+{
+    const long long ticks = dt.Ticks();
+    const size_t near_count = near_slots_.size();
+
+    if (near_count > 0)
+    {
+        std::vector<double> tsince(near_count);
+        std::vector<int> codes(near_count);
+
+        for (size_t i = 0; i < near_count; i++)
+        {
+            tsince[i] = static_cast<double>(ticks - near_.epoch[i])
+                / TicksPerMinute;
+        }
+
+        kernel(NearSpace(0), false, &tsince[0], near_count, &near_slots_[0],
+                position, velocity, &codes[0]);
+
+        for (size_t i = 0; i < near_count; i++)
+        {
+            if (codes[i] == kNearSpaceOk)
+            {
+                if (status)
+                {
+                    status[near_slots_[i]] = SGP4::kOk;
+                }
+                continue;
+            }
+
+            const size_t slot = near_slots_[i];
+            const SGP4::Status result = static_cast<SGP4::Status>(codes[i]);
+
+            if (!status)
+            {
+                SGP4::ThrowError(result,
+                        Eci(DateTime(near_.epoch[i]).AddMinutes(tsince[i]),
+                            Vector(position[3 * slot],
+                                position[3 * slot + 1],
+                                position[3 * slot + 2]),
+                            velocity ? Vector(velocity[3 * slot],
+                                velocity[3 * slot + 1],
+                                velocity[3 * slot + 2]) : Vector()));
+            }
+
+            status[slot] = result;
+            if (result != SGP4::kDecayed)
+            {
+                for (size_t k = 0; k < 3; k++)
+                {
+                    position[3 * slot + k] = T();
+                    if (velocity)
+                    {
+                        velocity[3 * slot + k] = T();
+                    }
+                }
+            }
+        }
+    }
+
+    for (size_t i = 0; i < deep_.size(); i++)
+    {
+        const size_t slot = deep_slots_[i];
+        const SGP4Model<Gravity>& model = deep_[i];
+        Eci eci(dt, Vector());
+
+        /*
+         * integrator state of this call only, so that threads can share
+         * the batch
+         */
+        SGP4::IntegratorParams params = SGP4::IntegratorParams();
+        const SGP4::Status result = model.FindPositionSDP4(
+                (dt - model.elements_.Epoch()).TotalMinutes(),
+                params, velocity != NULL, eci);
+        if (status)
+        {
+            status[slot] = result;
+        }
+        else if (result != SGP4::kOk)
+        {
+            SGP4::ThrowError(result, eci);
+        }
+
+        const Vector pos = eci.Position();
+        position[3 * slot] = static_cast<T>(pos.x);
+        position[3 * slot + 1] = static_cast<T>(pos.y);
+        position[3 * slot + 2] = static_cast<T>(pos.z);
+        if (velocity)
+        {
+            const Vector vel = eci.Velocity();
+            velocity[3 * slot] = static_cast<T>(vel.x);
+            velocity[3 * slot + 1] = static_cast<T>(vel.y);
+            velocity[3 * slot + 2] = static_cast<T>(vel.z);
+        }
+    }
+}
+
+/**
+ * Propagate one satellite of the batch to a time of its own, without
+ * throwing, as SGP4::TryFindPosition()
+ * @param[in] slot the index of the satellite within the batch
+ * @param[in] tsince minutes since the epoch of the satellite
+ * @param[out] eci the position and velocity, zero unless the result is
+ * SGP4::kOk or SGP4::kDecayed
+ * @returns the outcome
+ */
+template <typename Gravity>
+SGP4::Status SGP4BatchModel<Gravity>::TryFindPosition(
+        const size_t slot,
+        const double tsince,
+        Eci& eci) const
+{
+    const std::vector<size_t>::const_iterator near = std::lower_bound(
+            near_slots_.begin(), near_slots_.end(), slot);
+    if (near == near_slots_.end() || *near != slot)
+    {
+        const size_t i = static_cast<size_t>(std::lower_bound(
+                    deep_slots_.begin(), deep_slots_.end(), slot)
+                - deep_slots_.begin());
+
+        /*
+         * integrator state of this call only, as in FindPositions()
+         */
+        SGP4::IntegratorParams params = SGP4::IntegratorParams();
+        return deep_[i].FindPositionSDP4(tsince, params, true, eci);
+    }
+
+    /*
+     * the kernel over the columns from this satellite on, reading only
+     * the first
+     */
+    const size_t i = static_cast<size_t>(near - near_slots_.begin());
+    double position[3];
+    double velocity[3];
+    int code;
+    NearSpaceKernelsFor(SimdDispatch(), Gravity()).near_space(NearSpace(i),
+            true, &tsince, 1, NULL, position, velocity, &code);
+
+    const SGP4::Status result = static_cast<SGP4::Status>(code);
+    const DateTime dt = DateTime(near_.epoch[i]).AddMinutes(tsince);
+    if (result == SGP4::kOk || result == SGP4::kDecayed)
+    {
+        eci = Eci(dt,
+                Vector(position[0], position[1], position[2]),
+                Vector(velocity[0], velocity[1], velocity[2]));
+    }
+    else
+    {
+        eci = Eci(dt, Vector());
+    }
+    return result;
+}
+
+/**
+ * @param[in] first the first satellite of the view
+ * @returns the near earth columns from satellite first on, as used by
+ * the kernels
+ */
+template <typename Gravity>
+NearSpaceView SGP4BatchModel<Gravity>::NearSpace(const size_t first) const
+{
+    NearSpaceView view;
+    view.xmo = &near_.xmo[first];
+    view.omegao = &near_.omegao[first];
+    view.xnodeo = &near_.xnodeo[first];
+    view.eo = &near_.eo[first];
+    view.aodp = &near_.aodp[first];
+    view.xnodp = &near_.xnodp[first];
+    view.cosio = &near_.cosio[first];
+    view.sinio = &near_.sinio[first];
+    view.eta = &near_.eta[first];
+    view.t2cof = &near_.t2cof[first];
+    view.x1mth2 = &near_.x1mth2[first];
+    view.x3thm1 = &near_.x3thm1[first];
+    view.x7thm1 = &near_.x7thm1[first];
+    view.aycof = &near_.aycof[first];
+    view.xlcof = &near_.xlcof[first];
+    view.xnodcf = &near_.xnodcf[first];
+    view.c1 = &near_.c1[first];
+    view.bstarc4 = &near_.bstarc4[first];
+    view.omgdot = &near_.omgdot[first];
+    view.xnodot = &near_.xnodot[first];
+    view.xmdot = &near_.xmdot[first];
+    view.bstarc5 = &near_.bstarc5[first];
+    view.omgcof = &near_.omgcof[first];
+    view.xmcof = &near_.xmcof[first];
+    view.delmo = &near_.delmo[first];
+    view.sinmo = &near_.sinmo[first];
+    view.d2 = &near_.d2[first];
+    view.d3 = &near_.d3[first];
+    view.d4 = &near_.d4[first];
+    view.t3cof = &near_.t3cof[first];
+    view.t4cof = &near_.t4cof[first];
+    view.t5cof = &near_.t5cof[first];
+    return view;
+}
+
+template class SGP4BatchModel<Wgs72Old>;
+template class SGP4BatchModel<Wgs72>;
+template class SGP4BatchModel<Wgs84>;
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SGP4BATCH_H_
+#define SGP4BATCH_H_
+
+#include "SGP4.h"
+
+#include <cstddef>
+#include <vector>
+
+struct NearSpaceView;
+
+/**
+ * @brief Propagates a catalog of satellites to a common time.
+ *
+ * The initialised constants of every near earth satellite are stored
+ * column-wise (one array per constant) so that propagating the whole
+ * catalog walks each array sequentially. Deep space satellites, which need
+ * the resonance integrator, are kept as individual SGP4 models.
+ *
+ * Results are written into caller-provided arrays in the order in which
+ * the satellites were added, three values (x, y, z) per satellite.
+ *
+ * The near earth equations are evaluated several satellites at a time
+ * with the widest vector instructions the processor supports (AVX-512,
+ * AVX2 or SSE2 on x86, chosen at runtime), falling back to scalar code.
+ * Results can also be written in single precision, which evaluates twice
+ * as many satellites per instruction and halves the size of the output.
+ *
+ * Deep space satellites integrate with state of their own for each
+ * call, starting from checkpoints the batch keeps for them, so a const
+ * batch may be propagated from several threads at once. Single
+ * satellites can be propagated to times of their own from the same
+ * state, without keeping a model for each.
+ *
+ * Like SGP4Model the batch takes its gravity model as a template
+ * argument; SGP4Batch uses Wgs72.
+ */
+template <typename Gravity>
+class SGP4BatchModel
+{
+public:
+    SGP4BatchModel()
+    {
+    }
+
+    /**
+     * @param[in] tles the satellites to add
+     * @exception SatelliteException if a tle cannot be initialised
+     */
+    SGP4BatchModel(const std::vector<Tle>& tles);
+
+    virtual ~SGP4BatchModel()
+    {
+    }
+
+    size_t Add(const Tle& tle);
+    size_t Add(const SGP4Model<Gravity>& model);
+    void Clear();
+
+    /**
+     * @returns the number of satellites in the batch
+     */
+    size_t Size() const
+    {
+        return near_slots_.size() + deep_slots_.size();
+    }
+
+    void FindPositions(
+            const DateTime& dt,
+            double* position,
+            double* velocity) const;
+    void FindPositions(
+            const DateTime& dt,
+            double* position,
+            double* velocity,
+            SGP4::Status* status) const;
+    void FindPositions(
+            const DateTime& dt,
+            float* position,
+            float* velocity,
+            SGP4::Status* status) const;
+    SGP4::Status TryFindPosition(
+            const size_t slot,
+            const double tsince,
+            Eci& eci) const;
+
+private:
+    /*
+     * SGP4 constants for near earth satellites, one column per value
+     */
+    struct NearSpaceColumns
+    {
+        std::vector<long long> epoch;
+        std::vector<double> xmo;
+        std::vector<double> omegao;
+        std::vector<double> xnodeo;
+        std::vector<double> eo;
+        std::vector<double> aodp;
+        std::vector<double> xnodp;
+        std::vector<double> cosio;
+        std::vector<double> sinio;
+        std::vector<double> eta;
+        std::vector<double> t2cof;
+        std::vector<double> x1mth2;
+        std::vector<double> x3thm1;
+        std::vector<double> x7thm1;
+        std::vector<double> aycof;
+        std::vector<double> xlcof;
+        std::vector<double> xnodcf;
+        std::vector<double> c1;
+        std::vector<double> bstarc4;
+        std::vector<double> omgdot;
+        std::vector<double> xnodot;
+        std::vector<double> xmdot;
+        /*
+         * zero for satellites using the simple model, which makes the
+         * full near earth equations reduce to the simple ones
+         */
+        std::vector<double> bstarc5;
+        std::vector<double> omgcof;
+        std::vector<double> xmcof;
+        std::vector<double> delmo;
+        std::vector<double> sinmo;
+        std::vector<double> d2;
+        std::vector<double> d3;
+        std::vector<double> d4;
+        std::vector<double> t3cof;
+        std::vector<double> t4cof;
+        std::vector<double> t5cof;
+    };
+
+    void AddNearSpace(const SGP4Model<Gravity>& model);
+    NearSpaceView NearSpace(const size_t first) const;
+    template <typename T, typename Kernel>
+    void Propagate(
+            const DateTime& dt,
+            const Kernel kernel,
+            T* position,
+            T* velocity,
+            SGP4::Status* status) const;
+
+    NearSpaceColumns near_;
+    std::vector<size_t> near_slots_;
+    std::vector<SGP4Model<Gravity> > deep_;
+    std::vector<size_t> deep_slots_;
+};
+
+typedef SGP4BatchModel<Wgs72> SGP4Batch;
+
+#endif
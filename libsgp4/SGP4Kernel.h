@@ -0,0 +1,605 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SGP4KERNEL_H_
+#define SGP4KERNEL_H_
+
+#include "Globals.h"
+#include "SimdKernels.h"
+#include "SimdMath.h"
+
+#include <cstddef>
+
+/*
+ * The near earth equations of SGP4Model::FindPositionSGP4() and
+ * SGP4Model::CalculateFinalPositionVelocity(), evaluated for Lanes<V>()
+ * results at once with the constants of one of the gravity models.
+ * Included by the instruction set specific translation units, which must
+ * provide Sqrt(V) before including this file.
+ *
+ * With float lanes the secular terms, which grow without bound, are
+ * formed and reduced in double precision; everything after that runs in
+ * single precision.
+ */
+namespace
+{
+    /*
+     * load a full group of lanes from a column, converting to single
+     * precision for float lanes
+     */
+    template <typename V>
+    inline V LoadColumn(const double* p, double)
+    {
+        return Load<V>(p);
+    }
+
+    template <typename V>
+    inline V LoadColumn(const double* p, float)
+    {
+        float lanes[sizeof(V) / sizeof(float)];
+        for (size_t j = 0; j < Lanes<V>(); j++)
+        {
+            lanes[j] = static_cast<float>(p[j]);
+        }
+        return Load<V>(lanes);
+    }
+
+    /**
+     * Gather the lanes of one constant
+     * @param[in] column the constant
+     * @param[in] first the first result of the group
+     * @param[in] valid the number of real results in the group, the
+     * remaining lanes repeat the last one
+     * @param[in] broadcast if true use element 0 for every lane
+     */
+    template <typename V>
+    inline V LoadLanes(
+            const double* column,
+            const size_t first,
+            const size_t valid,
+            const bool broadcast)
+    {
+        typedef typename Element<V>::Type E;
+
+        if (broadcast)
+        {
+            return Broadcast<V>(column[0]);
+        }
+        if (valid == Lanes<V>())
+        {
+            return LoadColumn<V>(column + first, E());
+        }
+
+        E lanes[sizeof(V) / sizeof(E)];
+        for (size_t j = 0; j < Lanes<V>(); j++)
+        {
+            lanes[j] = static_cast<E>(
+                    column[first + (j < valid ? j : valid - 1)]);
+        }
+        return Load<V>(lanes);
+    }
+
+    /**
+     * Reduce an angle to [-pi, pi]
+     * @param[in] x the angle
+     */
+    inline double ReduceAngle(const double x)
+    {
+        return x - kTWOPI * Round(x * (1.0 / kTWOPI));
+    }
+
+    /**
+     * The secular updates for gravity and atmospheric drag
+     * @param[in] tsince the lanes of times
+     * @param[out] xmdf xmo + xmdot * t
+     * @param[out] omgadf omegao + omgdot * t
+     * @param[out] xnode xnodeo + xnodot * t + xnodcf * t^2
+     * @param[out] tempa the drag factor of the semi major axis
+     * @param[out] xlsec xnodp * templ, the drag term of xl
+     */
+    template <typename V>
+    inline void SecularTerms(
+            const NearSpaceView& view,
+            const size_t first,
+            const size_t valid,
+            const bool broadcast,
+            const double*,
+            const V& tsince,
+            V& xmdf,
+            V& omgadf,
+            V& xnode,
+            V& tempa,
+            V& xlsec,
+            double)
+    {
+#define SGP4_LANES(name) LoadLanes<V>(view.name, first, valid, broadcast)
+        xmdf = SGP4_LANES(xmo) + SGP4_LANES(xmdot) * tsince;
+        omgadf = SGP4_LANES(omegao) + SGP4_LANES(omgdot) * tsince;
+        const V xnoddf = SGP4_LANES(xnodeo) + SGP4_LANES(xnodot) * tsince;
+
+        const V tsq = tsince * tsince;
+        const V tcube = tsq * tsince;
+        const V tfour = tsince * tcube;
+        xnode = xnoddf + SGP4_LANES(xnodcf) * tsq;
+        tempa = 1.0 - SGP4_LANES(c1) * tsince - SGP4_LANES(d2) * tsq
+            - SGP4_LANES(d3) * tcube - SGP4_LANES(d4) * tfour;
+        const V templ = SGP4_LANES(t2cof) * tsq + (SGP4_LANES(t3cof) * tcube
+                + tfour * (SGP4_LANES(t4cof) + tsince * SGP4_LANES(t5cof)));
+        xlsec = SGP4_LANES(xnodp) * templ;
+#undef SGP4_LANES
+    }
+
+    /**
+     * The secular updates for float lanes, formed in double precision
+     * from the times. The angles are reduced to [-pi, pi] before rounding
+     * to float, and xlsec is xmdf + omgadf + xnodp * templ, reduced, so
+     * that the argument of keplers equation never holds a sum of several
+     * whole angles in single precision.
+     */
+    template <typename V>
+    inline void SecularTerms(
+            const NearSpaceView& view,
+            const size_t first,
+            const size_t valid,
+            const bool broadcast,
+            const double* times,
+            const V&,
+            V& xmdf,
+            V& omgadf,
+            V& xnode,
+            V& tempa,
+            V& xlsec,
+            float)
+    {
+        float lanes[5][sizeof(V) / sizeof(float)];
+
+        for (size_t j = 0; j < Lanes<V>(); j++)
+        {
+            const size_t k = first + (j < valid ? j : valid - 1);
+            const size_t i = broadcast ? 0 : k;
+            const double t = times[k];
+            const double tsq = t * t;
+            const double tcube = tsq * t;
+            const double tfour = t * tcube;
+
+            const double mean = view.xmo[i] + view.xmdot[i] * t;
+            const double perigee = view.omegao[i] + view.omgdot[i] * t;
+            const double templ = view.t2cof[i] * tsq + view.t3cof[i] * tcube
+                + tfour * (view.t4cof[i] + t * view.t5cof[i]);
+
+            lanes[0][j] = static_cast<float>(ReduceAngle(mean));
+            lanes[1][j] = static_cast<float>(ReduceAngle(perigee));
+            lanes[2][j] = static_cast<float>(ReduceAngle(view.xnodeo[i]
+                        + view.xnodot[i] * t + view.xnodcf[i] * tsq));
+            lanes[3][j] = static_cast<float>(1.0 - view.c1[i] * t
+                    - view.d2[i] * tsq - view.d3[i] * tcube
+                    - view.d4[i] * tfour);
+            lanes[4][j] = static_cast<float>(
+                    ReduceAngle(mean + perigee + view.xnodp[i] * templ));
+        }
+
+        xmdf = Load<V>(lanes[0]);
+        omgadf = Load<V>(lanes[1]);
+        xnode = Load<V>(lanes[2]);
+        tempa = Load<V>(lanes[3]);
+        xlsec = Load<V>(lanes[4]);
+    }
+
+    /**
+     * The argument of keplers equation, fmod(xl + xll - xnode, 2pi), where
+     * xl = xmp + omega + xnode + xlsec as in SGP4
+     */
+    template <typename V>
+    inline V KeplerArgument(
+            const V& xmp,
+            const V& omega,
+            const V& xnode,
+            const V& xlsec,
+            const V& xll,
+            double)
+    {
+        const V xl = xmp + omega + xnode + xlsec;
+        const V xlt = xl + xll;
+        return FmodTwoPi(xlt - xnode);
+    }
+
+    /**
+     * The argument of keplers equation for float lanes, where xlsec
+     * already holds xmp + omega, which is xmdf + omgadf, and the drag term
+     */
+    template <typename V>
+    inline V KeplerArgument(
+            const V&,
+            const V&,
+            const V&,
+            const V& xlsec,
+            const V& xll,
+            float)
+    {
+        return FmodTwoPi(xlsec + xll);
+    }
+
+    /*
+     * convergence of keplers equation, a few ulp of 2pi
+     */
+    inline double KeplerTolerance(double)
+    {
+        return 1.0e-12;
+    }
+
+    inline float KeplerTolerance(float)
+    {
+        return 1.0e-6f;
+    }
+
+    /**
+     * Finish solving keplers equation, given the last iterate with its sin
+     * and cos and its e cos E and e sin E terms. Nothing to do in double
+     * precision.
+     */
+    template <typename V>
+    inline void KeplerFinish(
+            const V&,
+            const V&,
+            const V&,
+            const V&,
+            V&,
+            V&,
+            V&,
+            V&,
+            double)
+    {
+    }
+
+    /**
+     * Finish solving keplers equation in single precision, where the
+     * tolerance is coarse, with one more newton step. The step is below
+     * the tolerance, so it is applied to sin and cos as a small rotation.
+     */
+    template <typename V>
+    inline void KeplerFinish(
+            const V& capu,
+            const V& axn,
+            const V& ayn,
+            const V& epw,
+            V& sinepw,
+            V& cosepw,
+            V& ecose,
+            V& esine,
+            float)
+    {
+        const V step = (capu - epw + esine) / (1.0f - ecose);
+        const V sinx = sinepw + step * cosepw;
+        const V cosx = cosepw - step * sinepw;
+        sinepw = sinx;
+        cosepw = cosx;
+        ecose = axn * cosepw + ayn * sinepw;
+        esine = axn * sinepw - ayn * cosepw;
+    }
+
+    /**
+     * Propagate one group of lanes
+     * @param[in] times minutes since epoch, one per result
+     * @param[out] out x y z, then the velocities when WithVelocity is set
+     * @param[out] code the NearSpaceStatus of each lane
+     */
+    template <typename V, typename Gravity, bool WithVelocity>
+    inline void NearSpaceGroup(
+            const NearSpaceView& view,
+            const size_t first,
+            const size_t valid,
+            const bool broadcast,
+            const double* times,
+            V* out,
+            V& code)
+    {
+        typedef typename Element<V>::Type E;
+
+#define SGP4_LANES(name) LoadLanes<V>(view.name, first, valid, broadcast)
+        const V tsince = LoadLanes<V>(times, first, valid, false);
+        const V cosio = SGP4_LANES(cosio);
+        const V sinio = SGP4_LANES(sinio);
+        const V x1mth2 = SGP4_LANES(x1mth2);
+        const V x3thm1 = SGP4_LANES(x3thm1);
+
+        /*
+         * update for secular gravity and atmospheric drag
+         */
+        V xmdf;
+        V omgadf;
+        V xnode;
+        V tempa;
+        V xlsec;
+        SecularTerms(view, first, valid, broadcast, times, tsince,
+                xmdf, omgadf, xnode, tempa, xlsec, E());
+        V tempe = SGP4_LANES(bstarc4) * tsince;
+
+        V sinxmdf;
+        V cosxmdf;
+        SinCos(xmdf, sinxmdf, cosxmdf);
+
+        /*
+         * the simple model has these constants zeroed
+         */
+        const V delomg = SGP4_LANES(omgcof) * tsince;
+        const V etacos = 1.0 + SGP4_LANES(eta) * cosxmdf;
+        const V delm = SGP4_LANES(xmcof)
+            * (etacos * etacos * etacos * - SGP4_LANES(delmo));
+        const V temp = delomg + delm;
+        const V xmp = xmdf + temp;
+        const V omega = omgadf - temp;
+
+        V sinxmp;
+        V cosxmp;
+        SinCos(xmp, sinxmp, cosxmp);
+
+        tempe += SGP4_LANES(bstarc5) * (sinxmp - SGP4_LANES(sinmo));
+
+        const V a = SGP4_LANES(aodp) * tempa * tempa;
+        V e = SGP4_LANES(eo) - tempe;
+
+        /*
+         * fix tolerance for error recognition
+         */
+        const V bad_e = Select(e <= E(-0.001),
+                Broadcast<V>(kNearSpaceEccentricity), V());
+        e = Select(e < E(1.0e-6), Broadcast<V>(1.0e-6), e);
+        e = Select(e > E(1.0 - 1.0e-6), Broadcast<V>(1.0 - 1.0e-6), e);
+
+        const V beta2 = 1.0 - e * e;
+        const V xn = E(Gravity::kXKE) / (a * Sqrt(a));
+        /*
+         * long period periodics
+         */
+        V sinomega;
+        V cosomega;
+        SinCos(omega, sinomega, cosomega);
+        const V axn = e * cosomega;
+        const V temp11 = 1.0 / (a * beta2);
+        const V xll = temp11 * SGP4_LANES(xlcof) * axn;
+        const V aynl = temp11 * SGP4_LANES(aycof);
+        const V ayn = e * sinomega + aynl;
+        const V elsq = axn * axn + ayn * ayn;
+
+        const V bad_elsq = Select(elsq >= 1.0,
+                Broadcast<V>(kNearSpaceElsq), V());
+
+        /*
+         * solve keplers equation, each lane stops iterating once it has
+         * converged and the loop ends when every lane has
+         */
+        const V capu = KeplerArgument(xmp, omega, xnode, xlsec, xll, E());
+        V epw = capu;
+
+        V sinepw = V();
+        V cosepw = V();
+        V ecose = V();
+        V esine = V();
+
+        const V max_newton_naphson = 1.25 * Abs(Sqrt(elsq));
+        V delta_epw = V();
+        __typeof__(V() < V()) active = (V() == V());
+
+        for (int k = 0; k < 10; k++)
+        {
+            V sinx;
+            V cosx;
+            SinCos(epw, sinx, cosx);
+            sinepw = Select(active, sinx, sinepw);
+            cosepw = Select(active, cosx, cosepw);
+            ecose = axn * cosepw + ayn * sinepw;
+            esine = axn * sinepw - ayn * cosepw;
+
+            const V f = capu - epw + esine;
+
+            active = active && !(Abs(f) < KeplerTolerance(E()));
+            if (!Any(active))
+            {
+                break;
+            }
+
+            const V fdot = 1.0 - ecose;
+
+            if (k == 0)
+            {
+                delta_epw = f / fdot;
+                delta_epw = Select(delta_epw > max_newton_naphson,
+                        max_newton_naphson, delta_epw);
+                delta_epw = Select(delta_epw < -max_newton_naphson,
+                        -max_newton_naphson, delta_epw);
+            }
+            else
+            {
+                delta_epw = f / (fdot + 0.5 * esine * delta_epw);
+            }
+
+            epw = Select(active, epw + delta_epw, epw);
+        }
+
+        KeplerFinish(capu, axn, ayn, epw, sinepw, cosepw, ecose, esine, E());
+
+        /*
+         * short period preliminary quantities
+         */
+        const V temp21 = 1.0 - elsq;
+        const V pl = a * temp21;
+
+        const V bad_pl = Select(pl < 0.0,
+                Broadcast<V>(kNearSpaceSemiLatusRectum), V());
+
+        const V r = a * (1.0 - ecose);
+        const V temp31 = 1.0 / r;
+        const V rdot = E(Gravity::kXKE) * Sqrt(a) * esine * temp31;
+        const V rfdot = E(Gravity::kXKE) * Sqrt(pl) * temp31;
+        const V temp32 = a * temp31;
+        const V betal = Sqrt(temp21);
+        const V temp33 = 1.0 / (1.0 + betal);
+        const V cosu = temp32 * (cosepw - axn + ayn * esine * temp33);
+        const V sinu = temp32 * (sinepw - ayn - axn * esine * temp33);
+        const V sin2u = 2.0 * sinu * cosu;
+        const V cos2u = 2.0 * cosu * cosu - 1.0;
+
+        /*
+         * update for short periodics
+         */
+        const V temp41 = 1.0 / pl;
+        const V temp42 = E(Gravity::kCK2) * temp41;
+        const V temp43 = temp42 * temp41;
+
+        const V rk = r * (1.0 - 1.5 * temp43 * betal * x3thm1)
+            + 0.5 * temp42 * x1mth2 * cos2u;
+        const V delu = 0.25 * temp43 * SGP4_LANES(x7thm1) * sin2u;
+        const V xnodek = xnode + 1.5 * temp43 * cosio * sin2u;
+        const V deli = 1.5 * temp43 * cosio * sinio * cos2u;
+        const V rdotk = rdot - xn * temp42 * x1mth2 * sin2u;
+        const V rfdotk = rfdot + xn * temp42 * (x1mth2 * cos2u + 1.5 * x3thm1);
+#undef SGP4_LANES
+
+        /*
+         * orientation vectors
+         * uk = u - delu and xinck = xincl + deli, where the corrections are
+         * small and sin / cos of u and xincl are already known, so rotate
+         * rather than evaluating atan2, sin and cos again
+         */
+        V sindelu;
+        V cosdelu;
+        V sindeli;
+        V cosdeli;
+        SinCosSmall(delu, sindelu, cosdelu);
+        SinCosSmall(deli, sindeli, cosdeli);
+        const V sinuk = sinu * cosdelu - cosu * sindelu;
+        const V cosuk = cosu * cosdelu + sinu * sindelu;
+        const V sinik = sinio * cosdeli + cosio * sindeli;
+        const V cosik = cosio * cosdeli - sinio * sindeli;
+        V sinnok;
+        V cosnok;
+        SinCos(xnodek, sinnok, cosnok);
+        const V xmx = -sinnok * cosik;
+        const V xmy = cosnok * cosik;
+        const V ux = xmx * sinuk + cosnok * cosuk;
+        const V uy = xmy * sinuk + sinnok * cosuk;
+        const V uz = sinik * sinuk;
+        const V vx = xmx * cosuk - cosnok * sinuk;
+        const V vy = xmy * cosuk - sinnok * sinuk;
+        const V vz = sinik * cosuk;
+
+        /*
+         * position, and the velocity if wanted; without it the velocity
+         * terms above are never used and the compiler drops them
+         */
+        out[0] = rk * ux * E(Gravity::kXKMPER);
+        out[1] = rk * uy * E(Gravity::kXKMPER);
+        out[2] = rk * uz * E(Gravity::kXKMPER);
+        if (WithVelocity)
+        {
+            out[3] = (rdotk * ux + rfdotk * vx) * E(Gravity::kXKMPER) / 60.0;
+            out[4] = (rdotk * uy + rfdotk * vy) * E(Gravity::kXKMPER) / 60.0;
+            out[5] = (rdotk * uz + rfdotk * vz) * E(Gravity::kXKMPER) / 60.0;
+        }
+
+        /*
+         * the first failing check wins, as when SGP4 throws
+         */
+        code = Select(rk < 1.0, Broadcast<V>(kNearSpaceDecayed), V());
+        code = Select(bad_pl != 0.0, bad_pl, code);
+        code = Select(bad_elsq != 0.0, bad_elsq, code);
+        code = Select(bad_e != 0.0, bad_e, code);
+    }
+
+    /**
+     * Propagate count results, a group of lanes at a time
+     */
+    template <typename V, typename Gravity, bool WithVelocity>
+    inline void NearSpaceLoop(
+            const NearSpaceView& view,
+            const bool broadcast,
+            const double* tsince,
+            const size_t count,
+            const size_t* slots,
+            typename Element<V>::Type* position,
+            typename Element<V>::Type* velocity,
+            int* status)
+    {
+        typedef typename Element<V>::Type E;
+
+        const size_t lanes = Lanes<V>();
+        const size_t outputs = WithVelocity ? 6 : 3;
+
+        for (size_t first = 0; first < count; first += lanes)
+        {
+            const size_t valid = count - first < lanes ? count - first : lanes;
+
+            V out[6];
+            V code;
+            NearSpaceGroup<V, Gravity, WithVelocity>(view, first, valid,
+                    broadcast, tsince, out, code);
+
+            E values[6][sizeof(V) / sizeof(E)];
+            E codes[sizeof(V) / sizeof(E)];
+            for (size_t k = 0; k < outputs; k++)
+            {
+                Store(values[k], out[k]);
+            }
+            Store(codes, code);
+
+            for (size_t j = 0; j < valid; j++)
+            {
+                const size_t slot = slots ? slots[first + j] : first + j;
+
+                position[3 * slot] = values[0][j];
+                position[3 * slot + 1] = values[1][j];
+                position[3 * slot + 2] = values[2][j];
+                if (WithVelocity)
+                {
+                    velocity[3 * slot] = values[3][j];
+                    velocity[3 * slot + 1] = values[4][j];
+                    velocity[3 * slot + 2] = values[5][j];
+                }
+                status[first + j] = static_cast<int>(codes[j]);
+            }
+        }
+    }
+
+    /**
+     * The NearSpaceKernel, or NearSpaceKernelFloat, for lane type V and
+     * gravity model Gravity
+     */
+    template <typename V, typename Gravity>
+    void FindPositionsNearSpace(
+            const NearSpaceView& view,
+            const bool broadcast,
+            const double* tsince,
+            const size_t count,
+            const size_t* slots,
+            typename Element<V>::Type* position,
+            typename Element<V>::Type* velocity,
+            int* status)
+    {
+        if (velocity)
+        {
+            NearSpaceLoop<V, Gravity, true>(view, broadcast, tsince, count,
+                    slots, position, velocity, status);
+        }
+        else
+        {
+            NearSpaceLoop<V, Gravity, false>(view, broadcast, tsince, count,
+                    slots, position, velocity, status);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "SiderealTime.h"
+
+#include "Globals.h"
+#include "Util.h"
+
+#include <cmath>
+
+/*
+ * the number of grid steps turned from one evaluation of the polynomial,
+ * the error of turning grows by about 1e-16 radians a step
+ */
+static const size_t kAnchorSteps = 256;
+
+/**
+ * Get Greenwich sidereal time at one instant
+ * @param[in] dt the instant
+ * @returns the angle, sine and cosine at dt
+ */
+SiderealAngle SiderealTime::FindAngle(const DateTime& dt)
+{
+    SiderealAngle result;
+    result.angle = dt.ToGreenwichSiderealTime();
+    result.sine = sin(result.angle);
+    result.cosine = cos(result.angle);
+    return result;
+}
+
+/**
+ * The rate of the polynomial of DateTime::ToGreenwichSiderealTime()
+ * @param[in] dt the instant
+ * @returns the rate of Greenwich sidereal time in radians per day
+ */
+static double FindRate(const DateTime& dt)
+{
+    const double t = (dt.ToJulian() - 2451545.0) / 36525.0;
+
+    /*
+     * seconds of rotation per Julian century, 240 to a degree
+     */
+    const double rate = (876600.0 * 3600.0 + 8640184.812866)
+        + 2.0 * 0.093104 * t
+        - 3.0 * 0.0000062 * t * t;
+
+    return Util::DegreesToRadians(rate / 240.0) / 36525.0;
+}
+
+/**
+ * Get Greenwich sidereal time, finding it only when dt is not the
+ * instant last asked for
+ * @param[in] dt the instant
+ * @returns the angle, valid until the next call
+ */
+const SiderealAngle& SiderealTime::Find(const DateTime& dt)
+{
+    if (!valid_ || dt != dt_)
+    {
+        angle_ = FindAngle(dt);
+        dt_ = dt;
+        valid_ = true;
+    }
+
+    return angle_;
+}
+
+/**
+ * Find Greenwich sidereal time across a regular time grid
+ * @param[in] start the first time of the grid
+ * @param[in] step the time between grid points
+ * @param[in] count the number of grid points
+ * @param[out] angles one per grid point
+ */
+void SiderealTime::FindGrid(
+        const DateTime& start,
+        const TimeSpan& step,
+        const size_t count,
+        SiderealAngle* angles)
+{
+    for (size_t first = 0; first < count; first += kAnchorSteps)
+    {
+        const DateTime anchor = start.AddTicks(
+                step.Ticks() * static_cast<long long>(first));
+        const SiderealAngle from = FindAngle(anchor);
+
+        /*
+         * the angle the earth turns each step, and its sine and cosine
+         */
+        const double turn = FindRate(anchor) * step.TotalDays();
+        const double sin_turn = sin(turn);
+        const double cos_turn = cos(turn);
+
+        const size_t last = count - first < kAnchorSteps
+            ? count : first + kAnchorSteps;
+
+        double sine = from.sine;
+        double cosine = from.cosine;
+
+        for (size_t i = first; i < last; i++)
+        {
+            SiderealAngle& angle = angles[i];
+            angle.angle = Util::WrapTwoPI(
+                    from.angle + static_cast<double>(i - first) * turn);
+            angle.sine = sine;
+            angle.cosine = cosine;
+
+            const double next_sine = sine * cos_turn + cosine * sin_turn;
+            cosine = cosine * cos_turn - sine * sin_turn;
+            sine = next_sine;
+        }
+    }
+}
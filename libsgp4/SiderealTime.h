@@ -0,0 +1,83 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SIDEREALTIME_H_
+#define SIDEREALTIME_H_
+
+#include "DateTime.h"
+#include "TimeSpan.h"
+
+#include <cstddef>
+
+/**
+ * @brief Greenwich sidereal time at one instant, in radians, and its sine
+ * and cosine.
+ */
+struct SiderealAngle
+{
+    double angle;
+    double sine;
+    double cosine;
+};
+
+/**
+ * @brief Provides Greenwich sidereal time, shared between the conversions
+ * made at the same instant.
+ *
+ * Find() keeps the last instant asked for, so the satellites and
+ * observers converted at one time find the sidereal time and its sine and
+ * cosine once; FindAngle() finds them at one instant without keeping
+ * them. FindGrid() finds it across a regular time grid by turning
+ * the earth a fixed angle each step, evaluating the polynomial of
+ * DateTime::ToGreenwichSiderealTime() only once every few hundred steps.
+ * The grid is as accurate as DateTime::ToGreenwichSiderealTime(), which
+ * for present dates is rounded to a few 1e-9 radians.
+ *
+ * A SiderealTime must only be used by one thread at a time.
+ */
+class SiderealTime
+{
+public:
+    SiderealTime()
+        : valid_(false)
+    {
+    }
+
+    virtual ~SiderealTime()
+    {
+    }
+
+    const SiderealAngle& Find(const DateTime& dt);
+
+    static SiderealAngle FindAngle(const DateTime& dt);
+
+    static void FindGrid(
+            const DateTime& start,
+            const TimeSpan& step,
+            const size_t count,
+            SiderealAngle* angles);
+
+private:
+    /*
+     * the last instant asked for and its angle
+     */
+    bool valid_;
+    DateTime dt_;
+    SiderealAngle angle_;
+};
+
+#endif
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "SimdKernels.h"
+
+#if defined(SGP4_SIMD_X86)
+
+/*
+ * everything outside the kernel is included before the target pragma so
+ * that no avx512 code leaks into shared inline functions
+ */
+#include "Globals.h"
+
+#include <cmath>
+#include <cstddef>
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+
+#include "SimdMath.h"
+
+namespace
+{
+    inline Double8 Sqrt(const Double8 x)
+    {
+        /*
+         * the masked form, _mm512_sqrt_pd trips -Wmaybe-uninitialized
+         */
+        return _mm512_mask_sqrt_pd(x, 0xff, x);
+    }
+
+    inline Float16 Sqrt(const Float16 x)
+    {
+        return _mm512_mask_sqrt_ps(x, 0xffff, x);
+    }
+}
+
+#include "SGP4Kernel.h"
+#include "LookAngleKernel.h"
+#include "GeodeticKernel.h"
+
+namespace
+{
+    const SimdKernels kKernels =
+    {
+        "avx512",
+        8,
+        {
+            FindPositionsNearSpace<Double8, Wgs72Old>,
+            FindPositionsNearSpace<Float16, Wgs72Old>
+        },
+        {
+            FindPositionsNearSpace<Double8, Wgs72>,
+            FindPositionsNearSpace<Float16, Wgs72>
+        },
+        {
+            FindPositionsNearSpace<Double8, Wgs84>,
+            FindPositionsNearSpace<Float16, Wgs84>
+        },
+        FindLookAngles<Double8>,
+        FindGeodetic<Double8>,
+        FindGeodetic<Float16>
+    };
+}
+
+#pragma GCC pop_options
+
+const SimdKernels* SimdKernelsAvx512()
+{
+    return &kKernels;
+}
+
+#else
+
+const SimdKernels* SimdKernelsAvx512()
+{
+    return NULL;
+}
+
+#endif
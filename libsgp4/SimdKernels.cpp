@@ -0,0 +1,108 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "SimdKernels.h"
+
+#include "SimdMath.h"
+
+namespace
+{
+    /*
+     * the portable single precision kernel uses generic vectors, which
+     * gcc lowers to whatever the target offers
+     */
+    inline Float4 Sqrt(const Float4 x)
+    {
+        Float4 r;
+        for (size_t j = 0; j < Lanes<Float4>(); j++)
+        {
+            r[j] = sqrtf(x[j]);
+        }
+        return r;
+    }
+}
+
+#include "SGP4Kernel.h"
+#include "LookAngleKernel.h"
+#include "GeodeticKernel.h"
+
+namespace
+{
+    const SimdKernels kKernels =
+    {
+        "scalar",
+        1,
+        {
+            FindPositionsNearSpace<double, Wgs72Old>,
+            FindPositionsNearSpace<Float4, Wgs72Old>
+        },
+        {
+            FindPositionsNearSpace<double, Wgs72>,
+            FindPositionsNearSpace<Float4, Wgs72>
+        },
+        {
+            FindPositionsNearSpace<double, Wgs84>,
+            FindPositionsNearSpace<Float4, Wgs84>
+        },
+        FindLookAngles<double>,
+        FindGeodetic<double>,
+        FindGeodetic<Float4>
+    };
+
+    const SimdKernels& SelectKernels()
+    {
+        const SimdKernels* kernels = NULL;
+
+#if defined(SGP4_SIMD_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+        {
+            kernels = SimdKernelsAvx512();
+        }
+        else if (__builtin_cpu_supports("avx2")
+                && __builtin_cpu_supports("fma"))
+        {
+            kernels = SimdKernelsAvx2();
+        }
+        else if (__builtin_cpu_supports("sse2"))
+        {
+            kernels = SimdKernelsSse2();
+        }
+#endif
+
+        return kernels ? *kernels : kKernels;
+    }
+}
+
+/**
+ * @returns the portable kernels, used when no instruction set specific
+ * kernels are available
+ */
+const SimdKernels* SimdKernelsScalar()
+{
+    return &kKernels;
+}
+
+/**
+ * @returns the kernels for the widest instruction set supported by the
+ * running processor
+ */
+const SimdKernels& SimdDispatch()
+{
+    static const SimdKernels& kernels = SelectKernels();
+    return kernels;
+}
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SIMDKERNELS_H_
+#define SIMDKERNELS_H_
+
+#include "Gravity.h"
+
+#include <cstddef>
+
+struct CoordTopocentric;
+
+/*
+ * the instruction set specific kernels are only built with gcc on x86,
+ * which can retarget a single translation unit with a pragma
+ */
+#if defined(__GNUC__) && !defined(__clang__) \
+    && (defined(__x86_64__) || defined(__i386__))
+#define SGP4_SIMD_X86 1
+#endif
+
+/**
+ * @brief Pointers to the near earth constants of one or more satellites.
+ *
+ * One array per constant, as held by SGP4Batch. The drag and perigee
+ * correction terms are zero for satellites using the simple model.
+ */
+struct NearSpaceView
+{
+    const double* xmo;
+    const double* omegao;
+    const double* xnodeo;
+    const double* eo;
+    const double* aodp;
+    const double* xnodp;
+    const double* cosio;
+    const double* sinio;
+    const double* eta;
+    const double* t2cof;
+    const double* x1mth2;
+    const double* x3thm1;
+    const double* x7thm1;
+    const double* aycof;
+    const double* xlcof;
+    const double* xnodcf;
+    const double* c1;
+    const double* bstarc4;
+    const double* omgdot;
+    const double* xnodot;
+    const double* xmdot;
+    const double* bstarc5;
+    const double* omgcof;
+    const double* xmcof;
+    const double* delmo;
+    const double* sinmo;
+    const double* d2;
+    const double* d3;
+    const double* d4;
+    const double* t3cof;
+    const double* t4cof;
+    const double* t5cof;
+};
+
+/*
+ * per result outcome of the near earth kernel, in the order the checks
+ * are made by SGP4
+ */
+enum NearSpaceStatus
+{
+    kNearSpaceOk = 0,
+    kNearSpaceEccentricity,
+    kNearSpaceElsq,
+    kNearSpaceSemiLatusRectum,
+    kNearSpaceDecayed
+};
+
+/**
+ * Near earth propagation of count results
+ * @param[in] view the satellite constants
+ * @param[in] broadcast if true every result uses element 0 of the view,
+ * otherwise result i uses element i
+ * @param[in] tsince minutes since epoch, one per result
+ * @param[in] count the number of results
+ * @param[in] slots the index to write result i to, or NULL for i
+ * @param[out] position 3 values per slot, x y z in kilometers
+ * @param[out] velocity 3 values per slot, x y z in kilometers per second,
+ * or NULL to compute positions only
+ * @param[out] status one NearSpaceStatus per result
+ */
+typedef void (*NearSpaceKernel)(
+        const NearSpaceView& view,
+        const bool broadcast,
+        const double* tsince,
+        const size_t count,
+        const size_t* slots,
+        double* position,
+        double* velocity,
+        int* status);
+
+/**
+ * Near earth propagation of count results in single precision, otherwise
+ * as NearSpaceKernel
+ */
+typedef void (*NearSpaceKernelFloat)(
+        const NearSpaceView& view,
+        const bool broadcast,
+        const double* tsince,
+        const size_t count,
+        const size_t* slots,
+        float* position,
+        float* velocity,
+        int* status);
+
+/**
+ * @brief The near earth kernels for one gravity model.
+ */
+struct NearSpaceKernels
+{
+    NearSpaceKernel near_space;
+    NearSpaceKernelFloat near_space_float;
+};
+
+/**
+ * @brief The topocentric frame of an observer at one time.
+ *
+ * The position and velocity of the observer, and the unit vectors
+ * pointing south, east and to the zenith from it, all in the Eci frame.
+ */
+struct TopocentricFrame
+{
+    double position[3];
+    double velocity[3];
+    double south[3];
+    double east[3];
+    double zenith[3];
+};
+
+/**
+ * Look angles of count objects from an observer, as
+ * Observer::GetLookAngle()
+ * @param[in] frame the observer
+ * @param[in] position 3 values per object, x y z in kilometers
+ * @param[in] velocity 3 values per object, x y z in kilometers per
+ * second, or NULL to leave the range rates zero
+ * @param[in] count the number of objects
+ * @param[out] look_angles one per object
+ */
+typedef void (*LookAngleKernel)(
+        const TopocentricFrame& frame,
+        const double* position,
+        const double* velocity,
+        const size_t count,
+        CoordTopocentric* look_angles);
+
+/**
+ * Geodetic positions of count Eci positions, as Eci::ToGeodetic()
+ * @param[in] position 3 values per position, x y z in kilometers
+ * @param[in] gmst the Greenwich sidereal time of each position in radians
+ * @param[in] count the number of positions
+ * @param[out] geodetic 3 values per position, latitude and longitude in
+ * radians and altitude in kilometers
+ */
+typedef void (*GeodeticKernel)(
+        const double* position,
+        const double* gmst,
+        const size_t count,
+        double* geodetic);
+
+/**
+ * Geodetic positions of count Eci positions in single precision,
+ * otherwise as GeodeticKernel
+ */
+typedef void (*GeodeticKernelFloat)(
+        const float* position,
+        const double* gmst,
+        const size_t count,
+        float* geodetic);
+
+/**
+ * @brief A set of kernels built for one instruction set.
+ */
+struct SimdKernels
+{
+    const char* name;
+    size_t lanes;
+    /*
+     * the gravity constants are compiled into the kernels, one set for
+     * each model of Gravity.h
+     */
+    NearSpaceKernels wgs72_old;
+    NearSpaceKernels wgs72;
+    NearSpaceKernels wgs84;
+    LookAngleKernel look_angles;
+    GeodeticKernel geodetic;
+    GeodeticKernelFloat geodetic_float;
+};
+
+/*
+ * the near earth kernels of a set for a gravity model
+ */
+inline const NearSpaceKernels& NearSpaceKernelsFor(
+        const SimdKernels& kernels,
+        const Wgs72Old&)
+{
+    return kernels.wgs72_old;
+}
+
+inline const NearSpaceKernels& NearSpaceKernelsFor(
+        const SimdKernels& kernels,
+        const Wgs72&)
+{
+    return kernels.wgs72;
+}
+
+inline const NearSpaceKernels& NearSpaceKernelsFor(
+        const SimdKernels& kernels,
+        const Wgs84&)
+{
+    return kernels.wgs84;
+}
+
+/*
+ * the kernels for each instruction set, NULL if not built
+ */
+const SimdKernels* SimdKernelsScalar();
+const SimdKernels* SimdKernelsSse2();
+const SimdKernels* SimdKernelsAvx2();
+const SimdKernels* SimdKernelsAvx512();
+
+/*
+ * the widest kernels supported by the running processor, chosen once
+ */
+const SimdKernels& SimdDispatch();
+
+#endif
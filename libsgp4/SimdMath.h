@@ -0,0 +1,474 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef SIMDMATH_H_
+#define SIMDMATH_H_
+
+#include "Globals.h"
+
+#include <cmath>
+#include <cstddef>
+
+/*
+ * Lane-generic maths used by the vectorised kernels. Every function is
+ * written once against a type V which is either double or one of the
+ * GCC vector types below, so the same source compiles to scalar, SSE2,
+ * AVX2 or AVX-512 code depending on the target of the including file.
+ * The vector types come with double or float lanes; constants must be
+ * converted to the lane type (Element<V>::Type) where they are not exact
+ * in single precision.
+ *
+ * Everything is in an anonymous namespace: each kernel translation unit
+ * is compiled for a different instruction set, and the copies must never
+ * be merged by the linker.
+ */
+namespace
+{
+    typedef double Double2 __attribute__((vector_size(16)));
+    typedef double Double4 __attribute__((vector_size(32)));
+    typedef double Double8 __attribute__((vector_size(64)));
+    typedef float Float4 __attribute__((vector_size(16)));
+    typedef float Float8 __attribute__((vector_size(32)));
+    typedef float Float16 __attribute__((vector_size(64)));
+
+    /*
+     * the type of one lane of V
+     */
+    template <typename V>
+    struct Element
+    {
+        typedef double Type;
+    };
+
+    template <>
+    struct Element<Float4>
+    {
+        typedef float Type;
+    };
+
+    template <>
+    struct Element<Float8>
+    {
+        typedef float Type;
+    };
+
+    template <>
+    struct Element<Float16>
+    {
+        typedef float Type;
+    };
+
+    template <typename V>
+    inline size_t Lanes()
+    {
+        return sizeof(V) / sizeof(typename Element<V>::Type);
+    }
+
+    template <typename V>
+    inline V Broadcast(const double x)
+    {
+        return V() + static_cast<typename Element<V>::Type>(x);
+    }
+
+    template <typename V>
+    inline V Load(const typename Element<V>::Type* p)
+    {
+        V v;
+        __builtin_memcpy(&v, p, sizeof(V));
+        return v;
+    }
+
+    template <typename V>
+    inline void Store(typename Element<V>::Type* p, const V& v)
+    {
+        __builtin_memcpy(p, &v, sizeof(V));
+    }
+
+    /**
+     * Gather a group of values spaced stride apart
+     * @param[in] values the value of object 0
+     * @param[in] stride the spacing of the objects
+     * @param[in] first the first object of the group
+     * @param[in] valid the number of real objects in the group, the
+     * remaining lanes repeat the last one
+     */
+    template <typename V>
+    inline V LoadStrided(
+            const typename Element<V>::Type* values,
+            const size_t stride,
+            const size_t first,
+            const size_t valid)
+    {
+        typename Element<V>::Type lanes[sizeof(V) / sizeof(values[0])];
+        for (size_t j = 0; j < Lanes<V>(); j++)
+        {
+            const size_t i = first + (j < valid ? j : valid - 1);
+            lanes[j] = values[stride * i];
+        }
+        return Load<V>(lanes);
+    }
+
+    template <typename M, typename V>
+    inline V Select(const M& mask, const V& a, const V& b)
+    {
+        return mask ? a : b;
+    }
+
+    inline bool Any(const bool mask)
+    {
+        return mask;
+    }
+
+    template <typename M>
+    inline bool Any(const M& mask)
+    {
+        for (size_t i = 0; i < sizeof(M) / sizeof(mask[0]); i++)
+        {
+            if (mask[i])
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template <typename V>
+    inline V Abs(const V& x)
+    {
+        return Select(x < 0.0, -x, x);
+    }
+
+    inline double Sqrt(const double x)
+    {
+        return sqrt(x);
+    }
+
+    /*
+     * 1.5 * 2^52 and 1.5 * 2^23, adding and subtracting which rounds away
+     * the fraction
+     */
+    inline double RoundingMagic(double)
+    {
+        return 6755399441055744.0;
+    }
+
+    inline float RoundingMagic(float)
+    {
+        return 12582912.0f;
+    }
+
+    /**
+     * Round to the nearest integer, valid for |x| < 2^51 in double
+     * precision and |x| < 2^22 in single
+     * @param[in] x the value to round
+     */
+    template <typename V>
+    inline V Round(const V& x)
+    {
+        const V magic = Broadcast<V>(
+                RoundingMagic(typename Element<V>::Type()));
+        return (x + magic) - magic;
+    }
+
+    /**
+     * sin and cos of an angle known to be small (the short periodic
+     * corrections, well below 0.01 radians), by Taylor series
+     * @param[in] x the angle
+     * @param[out] sinx
+     * @param[out] cosx
+     */
+    template <typename V>
+    inline void SinCosSmall(const V& x, V& sinx, V& cosx)
+    {
+        const V x2 = x * x;
+        sinx = x * (1.0 - x2 / 6.0 * (1.0 - x2 / 20.0 * (1.0 - x2 / 42.0)));
+        cosx = 1.0 - x2 / 2.0 * (1.0 - x2 / 12.0 * (1.0 - x2 / 30.0));
+    }
+
+    /**
+     * sin and cos, using the fdlibm kernel polynomials on [-pi/4, pi/4]
+     * after a three part Cody-Waite reduction by pi/2. Accurate to about
+     * 1 ulp for |x| < 1e6 radians, which covers any angle reached within
+     * a few years of a satellites epoch.
+     * @param[in] x the angle
+     * @param[out] sinx
+     * @param[out] cosx
+     */
+    template <typename V>
+    inline void SinCos(const V& x, V& sinx, V& cosx, double)
+    {
+        const double pio2_1 = 1.57079632673412561417e+00;
+        const double pio2_2 = 6.07710050630396597660e-11;
+        const double pio2_3 = 2.02226624871116645580e-21;
+
+        const double s1 = -1.66666666666666324348e-01;
+        const double s2 = 8.33333333332248946124e-03;
+        const double s3 = -1.98412698298579493134e-04;
+        const double s4 = 2.75573137070700676789e-06;
+        const double s5 = -2.50507602534068634195e-08;
+        const double s6 = 1.58969099521155010221e-10;
+
+        const double c1 = 4.16666666666666019037e-02;
+        const double c2 = -1.38888888888741095749e-03;
+        const double c3 = 2.48015872894767294178e-05;
+        const double c4 = -2.75573143513906633035e-07;
+        const double c5 = 2.08757232129817482790e-09;
+        const double c6 = -1.13596475577881948265e-11;
+
+        const V j = Round(x * (2.0 / kPI));
+        const V r = ((x - j * pio2_1) - j * pio2_2) - j * pio2_3;
+        const V z = r * r;
+
+        const V sinr = r + z * r
+            * (s1 + z * (s2 + z * (s3 + z * (s4 + z * (s5 + z * s6)))));
+
+        const V hz = 0.5 * z;
+        const V w = 1.0 - hz;
+        const V cosr = w + (((1.0 - w) - hz) + z * z
+            * (c1 + z * (c2 + z * (c3 + z * (c4 + z * (c5 + z * c6))))));
+
+        /*
+         * quadrant of the reduced angle, j mod 4
+         */
+        const V q = j - 4.0 * Round((j - 1.5) * 0.25);
+        const V s = Select(q == 1.0 || q == 3.0, cosr, sinr);
+        const V c = Select(q == 1.0 || q == 3.0, sinr, cosr);
+        sinx = Select(q >= 2.0, -s, s);
+        cosx = Select(q == 1.0 || q == 2.0, -c, c);
+    }
+
+    /**
+     * sin and cos in single precision, using the cephes sinf and cosf
+     * polynomials on [-pi/4, pi/4] after a three part reduction by pi/2.
+     * Accurate to about 1 ulp for |x| < 8192 radians.
+     * @param[in] x the angle
+     * @param[out] sinx
+     * @param[out] cosx
+     */
+    template <typename V>
+    inline void SinCos(const V& x, V& sinx, V& cosx, float)
+    {
+        const float pio2_1 = 1.5703125f;
+        const float pio2_2 = 4.837512969970703125e-4f;
+        const float pio2_3 = 7.54978995489188216e-8f;
+
+        const float s1 = -1.6666654611e-1f;
+        const float s2 = 8.3321608736e-3f;
+        const float s3 = -1.9515295891e-4f;
+
+        const float c1 = 4.166664568298827e-2f;
+        const float c2 = -1.388731625493765e-3f;
+        const float c3 = 2.443315711809948e-5f;
+
+        const V j = Round(x * static_cast<float>(2.0 / kPI));
+        const V r = ((x - j * pio2_1) - j * pio2_2) - j * pio2_3;
+        const V z = r * r;
+
+        const V sinr = r + z * r * (s1 + z * (s2 + z * s3));
+        const V cosr = 1.0f - 0.5f * z + z * z * (c1 + z * (c2 + z * c3));
+
+        /*
+         * quadrant of the reduced angle, j mod 4
+         */
+        const V q = j - 4.0f * Round((j - 1.5f) * 0.25f);
+        const V s = Select(q == 1.0f || q == 3.0f, cosr, sinr);
+        const V c = Select(q == 1.0f || q == 3.0f, sinr, cosr);
+        sinx = Select(q >= 2.0f, -s, s);
+        cosx = Select(q == 1.0f || q == 2.0f, -c, c);
+    }
+
+    template <typename V>
+    inline void SinCos(const V& x, V& sinx, V& cosx)
+    {
+        SinCos(x, sinx, cosx, typename Element<V>::Type());
+    }
+
+    inline void SinCos(const double x, double& sinx, double& cosx)
+    {
+        sinx = sin(x);
+        cosx = cos(x);
+    }
+
+    /*
+     * 2pi split in a leading and a trailing part, in double and in single
+     * precision
+     */
+    inline void TwoPiParts(double& twopi_1, double& twopi_2)
+    {
+        twopi_1 = 6.28318530717958623200e+00;
+        twopi_2 = 2.44929359829470635445e-16;
+    }
+
+    inline void TwoPiParts(float& twopi_1, float& twopi_2)
+    {
+        twopi_1 = 6.28125f;
+        twopi_2 = 1.9353071795864769e-3f;
+    }
+
+    /**
+     * fmod(x, 2pi), with 2pi split in two so that the reduction is exact
+     * for the magnitudes seen in propagation
+     * @param[in] x the angle
+     */
+    template <typename V>
+    inline V FmodTwoPi(const V& x)
+    {
+        typedef typename Element<V>::Type E;
+
+        E twopi_1;
+        E twopi_2;
+        TwoPiParts(twopi_1, twopi_2);
+
+        const V q = x * static_cast<E>(1.0 / kTWOPI);
+        V n = Round(q);
+        /*
+         * truncate towards zero
+         */
+        n = Select(q >= 0.0 && n > q, n - 1.0, n);
+        n = Select(q < 0.0 && n < q, n + 1.0, n);
+        return (x - n * twopi_1) - n * twopi_2;
+    }
+
+    inline double FmodTwoPi(const double x)
+    {
+        return fmod(x, kTWOPI);
+    }
+
+    /**
+     * atan2 in double precision, using the cephes atan rational function
+     * after reducing the ratio of the smaller to the larger argument to
+     * [-0.4142, 0.66]. Accurate to about 2 ulp. Zero for two zero
+     * arguments.
+     * @param[in] y the numerator
+     * @param[in] x the denominator
+     */
+    template <typename V>
+    inline V ArcTan2(const V& y, const V& x, double)
+    {
+        const double p0 = -8.750608600031904122785e-01;
+        const double p1 = -1.615753718733365076637e+01;
+        const double p2 = -7.500855792314704667340e+01;
+        const double p3 = -1.228866684490136173410e+02;
+        const double p4 = -6.485021904942025371773e+01;
+
+        const double q0 = 2.485846490142306297962e+01;
+        const double q1 = 1.650270098316988542046e+02;
+        const double q2 = 4.328810604912902668951e+02;
+        const double q3 = 4.853903996359136964868e+02;
+        const double q4 = 1.945506571482613964425e+02;
+
+        /*
+         * tan(3pi/8) and the low part of pi/2
+         */
+        const double tan3pio8 = 2.41421356237309504880;
+        const double morebits = 6.123233995736765886130e-17;
+
+        const V ay = Abs(y);
+        const V ax = Abs(x);
+
+        /*
+         * atan(ay / ax) is pi/2 + atan(-ax / ay) above tan(3pi/8), and
+         * pi/4 + atan((ay - ax) / (ay + ax)) above 0.66
+         */
+        const auto high = ay > tan3pio8 * ax;
+        const auto middle = ay > 0.66 * ax;
+        const V numerator = Select(high, -ax, Select(middle, ay - ax, ay));
+        V denominator = Select(high, ay, Select(middle, ay + ax, ax));
+        denominator = Select(denominator == 0.0, Broadcast<V>(1.0),
+                denominator);
+        const V offset = Select(high, Broadcast<V>(kPI / 2.0),
+                Select(middle, Broadcast<V>(kPI / 4.0), Broadcast<V>(0.0)));
+        const V low = Select(high, Broadcast<V>(morebits),
+                Select(middle, Broadcast<V>(0.5 * morebits),
+                    Broadcast<V>(0.0)));
+
+        const V t = numerator / denominator;
+        const V z = t * t;
+        const V p = (((p0 * z + p1) * z + p2) * z + p3) * z + p4;
+        const V q = ((((z + q0) * z + q1) * z + q2) * z + q3) * z + q4;
+        const V a = offset + ((t * (z * p / q) + t) + low);
+
+        const V angle = Select(x < 0.0, kPI - a, a);
+        return Select(y < 0.0, -angle, angle);
+    }
+
+    /**
+     * atan2 in single precision, using the cephes atanf polynomial after
+     * reducing the ratio of the smaller to the larger argument to
+     * [-0.4142, 0.4142]. Accurate to about 2 ulp. Zero for two zero
+     * arguments.
+     * @param[in] y the numerator
+     * @param[in] x the denominator
+     */
+    template <typename V>
+    inline V ArcTan2(const V& y, const V& x, float)
+    {
+        const float p0 = 8.05374449538e-2f;
+        const float p1 = -1.38776856032e-1f;
+        const float p2 = 1.99777106478e-1f;
+        const float p3 = -3.33329491539e-1f;
+
+        /*
+         * tan(3pi/8), tan(pi/8), and pi split into a float and the low
+         * part the float leaves out
+         */
+        const float tan3pio8 = 2.414213562373095f;
+        const float tanpio8 = 0.4142135623730950f;
+        const float pi = static_cast<float>(kPI);
+        const float pi_low = static_cast<float>(kPI - pi);
+
+        const V ay = Abs(y);
+        const V ax = Abs(x);
+
+        /*
+         * atan(ay / ax) is pi/2 + atan(-ax / ay) above tan(3pi/8), and
+         * pi/4 + atan((ay - ax) / (ay + ax)) above tan(pi/8)
+         */
+        const auto high = ay > tan3pio8 * ax;
+        const auto middle = ay > tanpio8 * ax;
+        const V numerator = Select(high, -ax, Select(middle, ay - ax, ay));
+        V denominator = Select(high, ay, Select(middle, ay + ax, ax));
+        denominator = Select(denominator == 0.0f, Broadcast<V>(1.0),
+                denominator);
+        const V offset = Select(high, Broadcast<V>(0.5f * pi),
+                Select(middle, Broadcast<V>(0.25f * pi), Broadcast<V>(0.0)));
+        const V low = Select(high, Broadcast<V>(0.5f * pi_low),
+                Select(middle, Broadcast<V>(0.25f * pi_low),
+                    Broadcast<V>(0.0)));
+
+        const V t = numerator / denominator;
+        const V z = t * t;
+        const V a = offset
+            + (((((p0 * z + p1) * z + p2) * z + p3) * z * t + t) + low);
+
+        const V angle = Select(x < 0.0f, (pi - a) + pi_low, a);
+        return Select(y < 0.0f, -angle, angle);
+    }
+
+    template <typename V>
+    inline V ArcTan2(const V& y, const V& x)
+    {
+        return ArcTan2(y, x, typename Element<V>::Type());
+    }
+
+    inline double ArcTan2(const double y, const double x)
+    {
+        return atan2(y, x);
+    }
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "SimdKernels.h"
+
+#if defined(SGP4_SIMD_X86)
+
+/*
+ * everything outside the kernel is included before the target pragma so
+ * that no sse2 code leaks into shared inline functions
+ */
+#include "Globals.h"
+
+#include <cmath>
+#include <cstddef>
+#include <immintrin.h>
+
+#pragma GCC push_options
+#pragma GCC target("sse2")
+
+#include "SimdMath.h"
+
+namespace
+{
+    inline Double2 Sqrt(const Double2 x)
+    {
+        return _mm_sqrt_pd(x);
+    }
+
+    inline Float4 Sqrt(const Float4 x)
+    {
+        return _mm_sqrt_ps(x);
+    }
+}
+
+#include "SGP4Kernel.h"
+#include "LookAngleKernel.h"
+#include "GeodeticKernel.h"
+
+namespace
+{
+    const SimdKernels kKernels =
+    {
+        "sse2",
+        2,
+        {
+            FindPositionsNearSpace<Double2, Wgs72Old>,
+            FindPositionsNearSpace<Float4, Wgs72Old>
+        },
+        {
+            FindPositionsNearSpace<Double2, Wgs72>,
+            FindPositionsNearSpace<Float4, Wgs72>
+        },
+        {
+            FindPositionsNearSpace<Double2, Wgs84>,
+            FindPositionsNearSpace<Float4, Wgs84>
+        },
+        FindLookAngles<Double2>,
+        FindGeodetic<Double2>,
+        FindGeodetic<Float4>
+    };
+}
+
+#pragma GCC pop_options
+
+const SimdKernels* SimdKernelsSse2()
+{
+    return &kKernels;
+}
+
+#else
+
+const SimdKernels* SimdKernelsSse2()
+{
+    return NULL;
+}
+
+#endif
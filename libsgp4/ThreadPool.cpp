@@ -0,0 +1,228 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ThreadPool.h"
+
+/**
+ * @param[in] threads the number of threads working on a loop, including
+ * the calling thread, 0 for one per hardware thread
+ */
+ThreadPool::ThreadPool(const size_t threads)
+    : task_(NULL),
+      pending_(0),
+      generation_(0),
+      stop_(false)
+{
+    size_t count = threads;
+    if (count == 0)
+    {
+        count = std::thread::hardware_concurrency();
+    }
+    if (count == 0)
+    {
+        count = 1;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        queues_.push_back(std::unique_ptr<Queue>(new Queue()));
+    }
+
+    /*
+     * the last queue belongs to the thread calling ParallelFor
+     */
+    for (size_t i = 0; i + 1 < count; i++)
+    {
+        threads_.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+
+    for (size_t i = 0; i < threads_.size(); i++)
+    {
+        threads_[i].join();
+    }
+}
+
+/**
+ * Run task(0) to task(count - 1) across the threads of the pool and wait
+ * for them all to finish. Must not be called from within a task.
+ * @param[in] count the number of tasks
+ * @param[in] task the task, called with the index of each task
+ * @exception the first exception thrown by a task, once every task has
+ * finished
+ */
+void ThreadPool::ParallelFor(
+        const size_t count,
+        const std::function<void(size_t)>& task)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> run(run_mutex_);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        pending_ = count;
+        error_ = std::exception_ptr();
+        generation_++;
+    }
+
+    /*
+     * deal the tasks out in contiguous runs, so that neighbouring tasks
+     * start out on the same thread
+     */
+    const size_t queues = queues_.size();
+    for (size_t q = 0; q < queues; q++)
+    {
+        Queue& queue = *queues_[q];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        for (size_t i = count * q / queues; i < count * (q + 1) / queues; i++)
+        {
+            queue.tasks.push_back(i);
+        }
+    }
+    wake_.notify_all();
+
+    RunTasks(queues - 1);
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (pending_ > 0)
+        {
+            done_.wait(lock);
+        }
+        task_ = NULL;
+        error = error_;
+        error_ = std::exception_ptr();
+    }
+
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::WorkerLoop(const size_t queue)
+{
+    size_t generation = 0;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            while (!stop_ && generation_ == generation)
+            {
+                wake_.wait(lock);
+            }
+            if (stop_)
+            {
+                return;
+            }
+            generation = generation_;
+        }
+
+        RunTasks(queue);
+    }
+}
+
+/*
+ * Run tasks until none are left in any queue
+ * @param[in] queue the queue of the calling thread
+ */
+void ThreadPool::RunTasks(const size_t queue)
+{
+    size_t index;
+
+    while (NextTask(queue, index))
+    {
+        /*
+         * a worker may still be looking for work from a previous loop, so
+         * take the task to run only once an index is in hand
+         */
+        const std::function<void(size_t)>* task;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            task = task_;
+        }
+
+        try
+        {
+            (*task)(index);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!error_)
+            {
+                error_ = std::current_exception();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--pending_ == 0)
+        {
+            done_.notify_all();
+        }
+    }
+}
+
+/*
+ * Take a task from the front of our own queue, or failing that steal one
+ * from the back of another
+ * @param[in] queue the queue of the calling thread
+ * @param[out] task the task index
+ * @returns false if there is no work left
+ */
+bool ThreadPool::NextTask(const size_t queue, size_t& task)
+{
+    const size_t queues = queues_.size();
+
+    for (size_t i = 0; i < queues; i++)
+    {
+        Queue& victim = *queues_[(queue + i) % queues];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+
+        if (!victim.tasks.empty())
+        {
+            if (i == 0)
+            {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+            }
+            else
+            {
+                task = victim.tasks.back();
+                victim.tasks.pop_back();
+            }
+            return true;
+        }
+    }
+
+    return false;
+}
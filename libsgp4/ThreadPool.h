@@ -0,0 +1,97 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A fixed set of threads running parallel loops.
+ *
+ * Each thread has its own queue of task indices. A thread takes work from
+ * the front of its own queue and, once that is empty, steals from the back
+ * of the other queues, so uneven tasks even out across the threads. The
+ * thread calling ParallelFor() takes part in the work.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @param[in] threads the number of threads working on a loop,
+     * including the calling thread, 0 for one per hardware thread
+     */
+    ThreadPool(const size_t threads = 0);
+
+    virtual ~ThreadPool();
+
+    /**
+     * @returns the number of threads working on a loop
+     */
+    size_t Size() const
+    {
+        return queues_.size();
+    }
+
+    void ParallelFor(
+            const size_t count,
+            const std::function<void(size_t)>& task);
+
+private:
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    void WorkerLoop(const size_t queue);
+    void RunTasks(const size_t queue);
+    bool NextTask(const size_t queue, size_t& task);
+
+    std::vector<std::unique_ptr<Queue> > queues_;
+    std::vector<std::thread> threads_;
+
+    /*
+     * serialises calls to ParallelFor
+     */
+    std::mutex run_mutex_;
+
+    /*
+     * state of the current loop, guarded by mutex_
+     */
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const std::function<void(size_t)>* task_;
+    size_t pending_;
+    size_t generation_;
+    bool stop_;
+    std::exception_ptr error_;
+};
+
+#endif
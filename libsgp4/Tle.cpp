@@ -17,8 +17,6 @@
 
 #include "Tle.h"
 
-#include <locale> 
-
 namespace
 {
     static const unsigned int TLE1_COL_NORADNUM = 2;
@@ -60,27 +58,106 @@ namespace
     static const unsigned int TLE2_LEN_MEANMOTION = 11;
     static const unsigned int TLE2_COL_REVATEPOCH = 63;
     static const unsigned int TLE2_LEN_REVATEPOCH = 5;
+
+    /*
+     * the powers of ten that are exact as doubles
+     */
+    static const double kPowersOfTen[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    inline bool IsDigit(const char c)
+    {
+        return c >= '0' && c <= '9';
+    }
+
+    /**
+     * The double nearest to mantissa * 10^exponent, as the standard
+     * library conversion gives. The mantissa and the power of ten are both
+     * exact, so a single correctly rounded multiply or divide suffices.
+     * @param[in] mantissa the decimal digits, below 2^53
+     * @param[in] exponent the power of ten, at most 22 in magnitude
+     */
+    inline double ScaleDecimal(
+            const unsigned long long mantissa,
+            const int exponent)
+    {
+        const double m = static_cast<double>(mantissa);
+        if (exponent < 0)
+        {
+            return m / kPowersOfTen[-exponent];
+        }
+        return m * kPowersOfTen[exponent];
+    }
+
+    /**
+     * Convert a right aligned, unsigned integer field
+     * @param[in] str the field
+     * @param[in] length the length of the field
+     * @param[out] val the result
+     * @exception TleException on conversion error
+     */
+    template <typename T>
+    void ExtractDigits(const char* str, const size_t length, T& val)
+    {
+        bool found_digit = false;
+        T temp = 0;
+
+        for (size_t i = 0; i < length; i++)
+        {
+            if (IsDigit(str[i]))
+            {
+                found_digit = true;
+                temp = static_cast<T>(temp * 10 + (str[i] - '0'));
+            }
+            else if (found_digit)
+            {
+                throw TleException("Unexpected non digit");
+            }
+            else if (str[i] != ' ')
+            {
+                throw TleException("Invalid character");
+            }
+        }
+
+        val = temp;
+    }
 }
 
 /**
- * Initialise the tle object.
+ * Initialise the tle object, decoding the fixed width fields in place.
+ * @param[in] line_one Tle line one
+ * @param[in] line_one_length the length of line one
+ * @param[in] line_two Tle line two
+ * @param[in] line_two_length the length of line two
  * @exception TleException
  */
-void Tle::Initialize()
+void Tle::Initialize(
+        const char* line_one,
+        const size_t line_one_length,
+        const char* line_two,
+        const size_t line_two_length)
 {
-    if (!IsValidLineLength(line_one_))
+    if (!IsValidLineLength(line_one_length))
     {
-        std::string err = "Invalid length for line one:\n" + line_one_ + "\n";
+        std::string err = "Invalid length for line one:\n"
+            + std::string(line_one, line_one_length) + "\n";
         throw TleException(err.c_str());
     }
 
-    if (!IsValidLineLength(line_two_))
+    if (!IsValidLineLength(line_two_length))
     {
-        std::string err = "Invalid length for line two:\n" + line_two_ + "\n";
+        std::string err = "Invalid length for line two:\n"
+            + std::string(line_two, line_two_length) + "\n";
 
         throw TleException(err.c_str());
     }
 
+    std::copy(line_one, line_one + TLE_LEN_LINE_DATA, line_one_);
+    std::copy(line_two, line_two + TLE_LEN_LINE_DATA, line_two_);
+
     if (line_one_[0] != '1')
     {
         throw TleException("Invalid line beginning for line one");
@@ -94,10 +171,10 @@ void Tle::Initialize()
     unsigned long sat_number_1;
     unsigned long sat_number_2;
 
-    ExtractULong(line_one_.substr(TLE1_COL_NORADNUM,
-                TLE1_LEN_NORADNUM), sat_number_1);
-    ExtractULong(line_two_.substr(TLE2_COL_NORADNUM,
-                TLE2_LEN_NORADNUM), sat_number_2);
+    ExtractULong(line_one_ + TLE1_COL_NORADNUM,
+            TLE1_LEN_NORADNUM, sat_number_1);
+    ExtractULong(line_two_ + TLE2_COL_NORADNUM,
+            TLE2_LEN_NORADNUM, sat_number_2);
 
     if (sat_number_1 != sat_number_2)
     {
@@ -108,43 +185,43 @@ void Tle::Initialize()
 
     if (name_.empty())
     {
-        name_ = line_one_.substr(TLE1_COL_NORADNUM, TLE1_LEN_NORADNUM);
+        name_.assign(line_one_ + TLE1_COL_NORADNUM, TLE1_LEN_NORADNUM);
     }
 
-    int_designator_ = line_one_.substr(TLE1_COL_INTLDESC_A,
+    int_designator_.assign(line_one_ + TLE1_COL_INTLDESC_A,
             TLE1_LEN_INTLDESC_A + TLE1_LEN_INTLDESC_B + TLE1_LEN_INTLDESC_C);
 
     int year = 0;
     double day = 0.0;
 
-    ExtractInteger(line_one_.substr(TLE1_COL_EPOCH_A,
-                TLE1_LEN_EPOCH_A), year);
-    ExtractDouble(line_one_.substr(TLE1_COL_EPOCH_B,
-                TLE1_LEN_EPOCH_B), 4, day);
-    ExtractDouble(line_one_.substr(TLE1_COL_MEANMOTIONDT2,
-                TLE1_LEN_MEANMOTIONDT2), 2, mean_motion_dt2_);
-    ExtractExponential(line_one_.substr(TLE1_COL_MEANMOTIONDDT6,
-                TLE1_LEN_MEANMOTIONDDT6), mean_motion_ddt6_);
-    ExtractExponential(line_one_.substr(TLE1_COL_BSTAR,
-                TLE1_LEN_BSTAR), bstar_);
+    ExtractInteger(line_one_ + TLE1_COL_EPOCH_A,
+            TLE1_LEN_EPOCH_A, year);
+    ExtractDouble(line_one_ + TLE1_COL_EPOCH_B,
+            TLE1_LEN_EPOCH_B, 4, day);
+    ExtractDouble(line_one_ + TLE1_COL_MEANMOTIONDT2,
+            TLE1_LEN_MEANMOTIONDT2, 2, mean_motion_dt2_);
+    ExtractExponential(line_one_ + TLE1_COL_MEANMOTIONDDT6,
+            TLE1_LEN_MEANMOTIONDDT6, mean_motion_ddt6_);
+    ExtractExponential(line_one_ + TLE1_COL_BSTAR,
+            TLE1_LEN_BSTAR, bstar_);
 
     /*
      * line 2
      */
-    ExtractDouble(line_two_.substr(TLE2_COL_INCLINATION,
-                TLE2_LEN_INCLINATION), 4, inclination_);
-    ExtractDouble(line_two_.substr(TLE2_COL_RAASCENDNODE,
-                TLE2_LEN_RAASCENDNODE), 4, right_ascending_node_);
-    ExtractDouble(line_two_.substr(TLE2_COL_ECCENTRICITY,
-                TLE2_LEN_ECCENTRICITY), -1, eccentricity_);
-    ExtractDouble(line_two_.substr(TLE2_COL_ARGPERIGEE,
-                TLE2_LEN_ARGPERIGEE), 4, argument_perigee_);
-    ExtractDouble(line_two_.substr(TLE2_COL_MEANANOMALY,
-                TLE2_LEN_MEANANOMALY), 4, mean_anomaly_);
-    ExtractDouble(line_two_.substr(TLE2_COL_MEANMOTION,
-                TLE2_LEN_MEANMOTION), 3, mean_motion_);
-    ExtractULong(line_two_.substr(TLE2_COL_REVATEPOCH,
-                TLE2_LEN_REVATEPOCH), orbit_number_);
+    ExtractDouble(line_two_ + TLE2_COL_INCLINATION,
+            TLE2_LEN_INCLINATION, 4, inclination_);
+    ExtractDouble(line_two_ + TLE2_COL_RAASCENDNODE,
+            TLE2_LEN_RAASCENDNODE, 4, right_ascending_node_);
+    ExtractDouble(line_two_ + TLE2_COL_ECCENTRICITY,
+            TLE2_LEN_ECCENTRICITY, -1, eccentricity_);
+    ExtractDouble(line_two_ + TLE2_COL_ARGPERIGEE,
+            TLE2_LEN_ARGPERIGEE, 4, argument_perigee_);
+    ExtractDouble(line_two_ + TLE2_COL_MEANANOMALY,
+            TLE2_LEN_MEANANOMALY, 4, mean_anomaly_);
+    ExtractDouble(line_two_ + TLE2_COL_MEANMOTION,
+            TLE2_LEN_MEANMOTION, 3, mean_motion_);
+    ExtractULong(line_two_ + TLE2_COL_REVATEPOCH,
+            TLE2_LEN_REVATEPOCH, orbit_number_);
     
     if (year < 57)
         year += 2000;
@@ -155,202 +232,128 @@ void Tle::Initialize()
 
 /**
  * Check 
- * @param str The string to check
+ * @param length The length of the line
  * @returns Whether true of the string has a valid length
  */
-bool Tle::IsValidLineLength(const std::string& str)
+bool Tle::IsValidLineLength(const size_t length)
 {
-    return str.length() == LineLength() ? true : false;
+    return length == LineLength() ? true : false;
 }
 
 /**
- * Convert a string containing an integer
- * @param[in] str The string to convert
+ * Convert a field containing an integer
+ * @param[in] str The field to convert
+ * @param[in] length The length of the field
  * @param[out] val The result
  * @exception TleException on conversion error
  */
-void Tle::ExtractInteger(const std::string& str, int& val)
+void Tle::ExtractInteger(const char* str, const size_t length, int& val)
 {
-    std::string temp;
-    bool found_digit = false;
-
-    for (std::string::const_iterator i = str.begin(); i != str.end(); ++i)
-    {
-        if (isdigit(*i))
-        {
-            found_digit = true;
-            temp += *i;
-        }
-        else if (found_digit)
-        {
-            throw TleException("Unexpected non digit");
-        }
-        else if (*i != ' ')
-        {
-            throw TleException("Invalid character");
-        }
-    }
-
-    if (temp.length() == 0)
-    {
-        temp += '0';
-    }
-
-    if (!Util::FromString<int>(temp, val))
-    {
-        throw TleException("Failed to convert value to integer");
-    }
+    ExtractDigits(str, length, val);
 }
 
 /**
- * Convert a string containing an unsigned integer
- * @param[in] str The string to convert
+ * Convert a field containing an unsigned integer
+ * @param[in] str The field to convert
+ * @param[in] length The length of the field
  * @param[out] val The result
  * @exception TleException on conversion error
  */
-void Tle::ExtractUInteger(const std::string& str, unsigned int& val)
+void Tle::ExtractUInteger(
+        const char* str,
+        const size_t length,
+        unsigned int& val)
 {
-    std::string temp;
-    bool found_digit = false;
-
-    for (std::string::const_iterator i = str.begin(); i != str.end(); ++i)
-    {
-        if (isdigit(*i))
-        {
-            found_digit = true;
-            temp += *i;
-        }
-        else if (found_digit)
-        {
-            throw TleException("Unexpected non digit");
-        }
-        else if (*i != ' ')
-        {
-            throw TleException("Invalid character");
-        }
-    }
-
-    if (temp.length() == 0)
-    {
-        temp += '0';
-    }
-
-    if (!Util::FromString<unsigned int>(temp, val))
-    {
-        throw TleException("Failed to convert value to integer");
-    }
+    ExtractDigits(str, length, val);
 }
 
 /**
- * Convert a string containing an unsigned long
- * @param[in] str The string to convert
+ * Convert a field containing an unsigned long
+ * @param[in] str The field to convert
+ * @param[in] length The length of the field
  * @param[out] val The result
  * @exception TleException on conversion error
  */
-void Tle::ExtractULong(const std::string& str, unsigned long& val)
+void Tle::ExtractULong(
+        const char* str,
+        const size_t length,
+        unsigned long& val)
 {
-    std::string temp;
-    bool found_digit = false;
-
-    for (std::string::const_iterator i = str.begin(); i != str.end(); ++i)
-    {
-        if (isdigit(*i))
-        {
-            found_digit = true;
-            temp += *i;
-        }
-        else if (found_digit)
-        {
-            throw TleException("Unexpected non digit");
-        }
-        else if (*i != ' ')
-        {
-            throw TleException("Invalid character");
-        }
-    }
-
-    if (temp.length() == 0)
-    {
-        temp += '0';
-    }
-
-    if (!Util::FromString<unsigned long>(temp, val))
-    {
-        throw TleException("Failed to convert value to integer");
-    }
+    ExtractDigits(str, length, val);
 }
 
 /**
- * Convert a string containing an double
- * @param[in] str The string to convert
+ * Convert a field containing an double
+ * @param[in] str The field to convert
+ * @param[in] length The length of the field
  * @param[in] point_pos The position of the decimal point. (-1 if none)
  * @param[out] val The result
  * @exception TleException on conversion error
  */
-void Tle::ExtractDouble(const std::string& str, int point_pos, double& val)
+void Tle::ExtractDouble(
+        const char* str,
+        const size_t length,
+        int point_pos,
+        double& val)
 {
-    std::string temp;
+    bool negative = false;
+    bool found_sign = false;
     bool found_digit = false;
+    /*
+     * whether the field holds a number at all, a blank integer part
+     * reads as zero but a lone sign does not
+     */
+    bool found_value = false;
+    unsigned long long mantissa = 0;
+    int exponent = 0;
 
-    for (std::string::const_iterator i = str.begin(); i != str.end(); ++i)
+    for (size_t i = 0; i < length; i++)
     {
+        const int pos = static_cast<int>(i);
+        const char c = str[i];
+
         /*
          * integer part
          */
-        if (i < str.begin() + point_pos - 1)
+        if (pos < point_pos - 1)
         {
-            bool done = false;
-
-            if (i == str.begin())
+            if (i == 0 && (c == '-' || c == '+'))
             {
-                if(*i == '-' || *i == '+')
-                {
-                    /*
-                     * first character could be signed
-                     */
-                    temp += *i;
-                    done = true;
-                }
+                /*
+                 * first character could be signed
+                 */
+                negative = c == '-';
+                found_sign = true;
             }
-
-            if (!done)
+            else if (IsDigit(c))
+            {
+                found_digit = true;
+                found_value = true;
+                mantissa = mantissa * 10 + static_cast<unsigned int>(c - '0');
+            }
+            else if (found_digit)
+            {
+                throw TleException("Unexpected non digit");
+            }
+            else if (c != ' ')
             {
-                if (isdigit(*i))
-                {
-                    found_digit = true;
-                    temp += *i;
-                }
-                else if (found_digit)
-                {
-                    throw TleException("Unexpected non digit");
-                }
-                else if (*i != ' ')
-                {
-                    throw TleException("Invalid character");
-                }
+                throw TleException("Invalid character");
             }
         }
         /*
          * decimal point
          */
-        else if (i == str.begin() + point_pos - 1)
+        else if (pos == point_pos - 1)
         {
-            if (temp.length() == 0)
+            if (!found_sign && !found_digit)
             {
                 /*
-                 * integer part is blank, so add a '0'
+                 * integer part is blank, so reads as zero
                  */
-                temp += '0';
+                found_value = true;
             }
 
-            if (*i == '.')
-            {
-                /*
-                 * decimal point found
-                 */
-                temp += *i;
-            }
-            else
+            if (c != '.')
             {
                 throw TleException("Failed to find decimal point");
             }
@@ -360,21 +363,22 @@ void Tle::ExtractDouble(const std::string& str, int point_pos, double& val)
          */
         else
         {
-            if (i == str.begin() && point_pos == -1)
+            if (i == 0 && point_pos == -1)
             {
                 /*
-                 * no decimal point expected, add 0. beginning
+                 * no decimal point expected, the field is all fraction
                  */
-                temp += '0';
-                temp += '.';
+                found_value = true;
             }
             
             /*
              * should be a digit
              */
-            if (isdigit(*i))
+            if (IsDigit(c))
             {
-                temp += *i;
+                found_value = true;
+                mantissa = mantissa * 10 + static_cast<unsigned int>(c - '0');
+                exponent--;
             }
             else
             {
@@ -383,46 +387,58 @@ void Tle::ExtractDouble(const std::string& str, int point_pos, double& val)
         }
     }
 
-    if (!Util::FromString<double>(temp, val))
+    if (!found_value)
     {
         throw TleException("Failed to convert value to double");
     }
+
+    val = ScaleDecimal(mantissa, exponent);
+    if (negative)
+    {
+        val = -val;
+    }
 }
 
 /**
- * Convert a string containing an exponential
- * @param[in] str The string to convert
+ * Convert a field containing an exponential
+ * @param[in] str The field to convert
+ * @param[in] length The length of the field
  * @param[out] val The result
  * @exception TleException on conversion error
  */
-void Tle::ExtractExponential(const std::string& str, double& val)
+void Tle::ExtractExponential(
+        const char* str,
+        const size_t length,
+        double& val)
 {
-    std::string temp;
-
-    for (std::string::const_iterator i = str.begin(); i != str.end(); ++i)
+    bool negative = false;
+    bool negative_exponent = false;
+    bool found_exponent = false;
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+
+    for (size_t i = 0; i < length; i++)
     {
-        if (i == str.begin())
+        const char c = str[i];
+
+        if (i == 0)
         {
-            if (*i == '-' || *i == '+' || *i == ' ')
+            if (c == '-' || c == '+' || c == ' ')
             {
-                if (*i == '-')
-                {
-                    temp += *i;
-                }
-                temp += '0';
-                temp += '.';
+                negative = c == '-';
             }
             else
             {
                 throw TleException("Invalid sign");
             }
         }
-        else if (i == str.begin() + static_cast<std::ptrdiff_t>(str.length()) - 2)
+        else if (length >= 2 && i == length - 2)
         {
-            if (*i == '-' || *i == '+')
+            if (c == '-' || c == '+')
             {
-                temp += 'e';
-                temp += *i;
+                negative_exponent = c == '-';
+                found_exponent = true;
             }
             else
             {
@@ -431,19 +447,35 @@ void Tle::ExtractExponential(const std::string& str, double& val)
         }
         else
         {
-            if (isdigit(*i))
+            if (!IsDigit(c))
+            {
+                throw TleException("Invalid digit");
+            }
+
+            if (found_exponent)
             {
-                temp += *i;
+                exponent = exponent * 10 + (c - '0');
             }
             else
             {
-                throw TleException("Invalid digit");
+                mantissa = mantissa * 10 + static_cast<unsigned int>(c - '0');
+                digits++;
             }
         }
     }
 
-    if (!Util::FromString<double>(temp, val))
+    if (found_exponent && length < 3)
     {
         throw TleException("Failed to convert value to double");
     }
+
+    /*
+     * the digits are a fraction, 0.ddddd
+     */
+    val = ScaleDecimal(mantissa,
+            (negative_exponent ? -exponent : exponent) - digits);
+    if (negative)
+    {
+        val = -val;
+    }
 }
@@ -22,6 +22,9 @@
 #include "DateTime.h"
 #include "TleException.h"
 
+#include <algorithm>
+#include <cstddef>
+
 /**
  * @brief Processes a two-line element set used to convey OrbitalElements.
  *
@@ -37,10 +40,9 @@ public:
      */
     Tle(const std::string& line_one,
             const std::string& line_two)
-        : line_one_(line_one),
-        line_two_(line_two)
     {
-        Initialize();
+        Initialize(line_one.data(), line_one.length(),
+                line_two.data(), line_two.length());
     }
 
     /**
@@ -52,11 +54,35 @@ public:
     Tle(const std::string& name,
             const std::string& line_one,
             const std::string& line_two)
-        : name_(name),
-        line_one_(line_one),
-        line_two_(line_two)
+        : name_(name)
     {
-        Initialize();
+        Initialize(line_one.data(), line_one.length(),
+                line_two.data(), line_two.length());
+    }
+
+    /**
+     * @details Initialise directly from character buffers, such as the
+     * lines of a file read into memory. The lines need not be null
+     * terminated and nothing is allocated unless a name is given.
+     * @param[in] name Satellite name, may be NULL
+     * @param[in] name_length the length of the name
+     * @param[in] line_one Tle line one
+     * @param[in] line_one_length the length of line one
+     * @param[in] line_two Tle line two
+     * @param[in] line_two_length the length of line two
+     */
+    Tle(const char* name,
+            const size_t name_length,
+            const char* line_one,
+            const size_t line_one_length,
+            const char* line_two,
+            const size_t line_two_length)
+    {
+        if (name != NULL)
+        {
+            name_.assign(name, name_length);
+        }
+        Initialize(line_one, line_one_length, line_two, line_two_length);
     }
 
     /**
@@ -66,8 +92,8 @@ public:
     Tle(const Tle& tle)
     {
         name_ = tle.name_;
-        line_one_ = tle.line_one_;
-        line_two_ = tle.line_two_;
+        std::copy(tle.line_one_, tle.line_one_ + TLE_LEN_LINE_DATA, line_one_);
+        std::copy(tle.line_two_, tle.line_two_ + TLE_LEN_LINE_DATA, line_two_);
 
         norad_number_ = tle.norad_number_;
         int_designator_ = tle.int_designator_;
@@ -106,7 +132,7 @@ public:
      */
     std::string Line1() const
     {
-        return line_one_;
+        return std::string(line_one_, TLE_LEN_LINE_DATA);
     }
 
     /**
@@ -115,7 +141,7 @@ public:
      */
     std::string Line2() const
     {
-        return line_two_;
+        return std::string(line_two_, TLE_LEN_LINE_DATA);
     }
 
     /**
@@ -311,18 +337,41 @@ public:
     }
 
 private:
-    void Initialize();
-    static bool IsValidLineLength(const std::string& str);
-    void ExtractInteger(const std::string& str, int& val);
-    void ExtractUInteger(const std::string& str, unsigned int& val);
-    void ExtractULong(const std::string& str, unsigned long& val);
-    void ExtractDouble(const std::string& str, int point_pos, double& val);
-    void ExtractExponential(const std::string& str, double& val);
+    static const unsigned int TLE_LEN_LINE_DATA = 69;
+    static const unsigned int TLE_LEN_LINE_NAME = 22;
+
+    void Initialize(
+            const char* line_one,
+            const size_t line_one_length,
+            const char* line_two,
+            const size_t line_two_length);
+    static bool IsValidLineLength(const size_t length);
+    static void ExtractInteger(const char* str, const size_t length, int& val);
+    static void ExtractUInteger(
+            const char* str,
+            const size_t length,
+            unsigned int& val);
+    static void ExtractULong(
+            const char* str,
+            const size_t length,
+            unsigned long& val);
+    static void ExtractDouble(
+            const char* str,
+            const size_t length,
+            int point_pos,
+            double& val);
+    static void ExtractExponential(
+            const char* str,
+            const size_t length,
+            double& val);
 
 private:
     std::string name_;
-    std::string line_one_;
-    std::string line_two_;
+    /*
+     * the lines are a fixed size, so are held inline
+     */
+    char line_one_[TLE_LEN_LINE_DATA];
+    char line_two_[TLE_LEN_LINE_DATA];
 
     unsigned long norad_number_;
     std::string int_designator_;
@@ -337,9 +386,6 @@ private:
     double mean_anomaly_;
     double mean_motion_;
     unsigned long orbit_number_;
-
-    static const unsigned int TLE_LEN_LINE_DATA = 69;
-    static const unsigned int TLE_LEN_LINE_NAME = 22;
 };
 
 
@@ -0,0 +1,330 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "TleCatalog.h"
+
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    /*
+     * the size of the pieces a file is cut into for parsing
+     */
+    static const size_t kPieceSize = 1 << 20;
+
+    /**
+     * @brief One line of the buffer, without its line ending or trailing
+     * white space.
+     */
+    struct Line
+    {
+        const char* begin;
+        size_t length;
+        /*
+         * the start of the following line
+         */
+        const char* next;
+    };
+
+    /**
+     * The line starting at begin
+     * @param[in] begin the start of the line
+     * @param[in] end the end of the buffer
+     */
+    Line ReadLine(const char* begin, const char* end)
+    {
+        const char* newline = static_cast<const char*>(
+                memchr(begin, '\n', static_cast<size_t>(end - begin)));
+        const char* stop = newline ? newline : end;
+
+        Line line;
+        line.begin = begin;
+        line.next = newline ? newline + 1 : end;
+        while (stop > begin
+                && (stop[-1] == ' ' || stop[-1] == '\t' || stop[-1] == '\r'))
+        {
+            stop--;
+        }
+        line.length = static_cast<size_t>(stop - begin);
+        return line;
+    }
+
+    /**
+     * The start of the line before the line starting at begin
+     * @param[in] data the start of the buffer
+     * @param[in] begin the start of a line after the first
+     */
+    const char* PreviousLine(const char* data, const char* begin)
+    {
+        const char* p = begin - 1;
+        while (p > data && p[-1] != '\n')
+        {
+            p--;
+        }
+        return p;
+    }
+
+    bool IsLineOne(const Line& line)
+    {
+        return line.length >= 2 && line.begin[0] == '1' && line.begin[1] == ' ';
+    }
+
+    bool IsLineTwo(const Line& line)
+    {
+        return line.length >= 2 && line.begin[0] == '2' && line.begin[1] == ' ';
+    }
+
+    /**
+     * Whether a line one starts at begin, that is a line starting with
+     * "1 " followed by one starting with "2 "
+     */
+    bool IsRecord(const char* begin, const char* end)
+    {
+        if (begin >= end)
+        {
+            return false;
+        }
+        const Line one = ReadLine(begin, end);
+        return IsLineOne(one) && one.next < end
+            && IsLineTwo(ReadLine(one.next, end));
+    }
+
+    /**
+     * @brief The tles and errors of one piece of the buffer.
+     */
+    struct Piece
+    {
+        std::vector<Tle> tles;
+        std::vector<TleCatalog::Error> errors;
+        /*
+         * the number of lines starting in the piece
+         */
+        size_t lines;
+    };
+
+    /**
+     * Parse the records whose line one starts within [begin, end). A
+     * record may read the name line before begin or the line two after
+     * end, which the neighbouring pieces then skip.
+     * @param[in] data the start of the buffer
+     * @param[in] data_end the end of the buffer
+     * @param[in] begin the start of the piece, at the start of a line
+     * @param[in] end the end of the piece, at the start of a line
+     * @param[out] piece the results, with line numbers counted from the
+     * start of the piece
+     */
+    void ParsePiece(
+            const char* data,
+            const char* data_end,
+            const char* begin,
+            const char* end,
+            Piece& piece)
+    {
+        piece.lines = static_cast<size_t>(std::count(begin, end, '\n'));
+
+        const char* p = begin;
+        size_t number = 0;
+        while (p < end)
+        {
+            const Line line = ReadLine(p, data_end);
+
+            if (line.length == 0)
+            {
+                p = line.next;
+                number++;
+            }
+            else if (IsRecord(p, data_end))
+            {
+                const Line two = ReadLine(line.next, data_end);
+
+                /*
+                 * the line before is the name, unless it is blank or the
+                 * line two of the previous record
+                 */
+                const char* name = NULL;
+                size_t name_length = 0;
+                if (p > data)
+                {
+                    const char* previous = PreviousLine(data, p);
+                    const Line before = ReadLine(previous, data_end);
+                    const bool after_record = previous > data
+                        && IsRecord(PreviousLine(data, previous), data_end);
+                    if (before.length > 0 && !(IsLineTwo(before) && after_record))
+                    {
+                        name = before.begin;
+                        name_length = before.length;
+                        /*
+                         * some sources write names as "0 NAME"
+                         */
+                        if (name_length > 2 && name[0] == '0' && name[1] == ' ')
+                        {
+                            name += 2;
+                            name_length -= 2;
+                        }
+                    }
+                }
+
+                try
+                {
+                    piece.tles.push_back(Tle(name, name_length,
+                                line.begin, line.length,
+                                two.begin, two.length));
+                }
+                catch (TleException& e)
+                {
+                    TleCatalog::Error error = { number, e.what() };
+                    piece.errors.push_back(error);
+                }
+
+                p = two.next;
+                number += 2;
+            }
+            else if (line.next < data_end && IsRecord(line.next, data_end))
+            {
+                /*
+                 * name line, read with the record that follows
+                 */
+                p = line.next;
+                number++;
+            }
+            else if (IsLineTwo(line) && p > data
+                    && IsRecord(PreviousLine(data, p), data_end))
+            {
+                /*
+                 * line two of a record in the previous piece
+                 */
+                p = line.next;
+                number++;
+            }
+            else
+            {
+                TleCatalog::Error error = { number,
+                    "Line is not part of a tle" };
+                piece.errors.push_back(error);
+                p = line.next;
+                number++;
+            }
+        }
+    }
+}
+
+/**
+ * Map an element file into memory and add its tles to the catalog
+ * @param[in] filename the file to load
+ * @param[in] pool the threads to parse with
+ * @exception TleException if the file cannot be read
+ */
+void TleCatalog::Load(const std::string& filename, ThreadPool& pool)
+{
+    MappedFile file;
+    if (!file.Map(filename))
+    {
+        std::string err = "Failed to read " + filename;
+        throw TleException(err.c_str());
+    }
+    Parse(file.Data(), file.Length(), pool);
+}
+
+/**
+ * Add the tles held in a buffer to the catalog
+ * @param[in] data the contents of an element file
+ * @param[in] length the length of the buffer
+ * @param[in] pool the threads to parse with
+ */
+void TleCatalog::Parse(
+        const char* data,
+        const size_t length,
+        ThreadPool& pool)
+{
+    if (length == 0)
+    {
+        return;
+    }
+
+    const char* data_end = data + length;
+
+    /*
+     * cut the buffer into pieces, moving each cut to the start of a line
+     */
+    size_t count = length / kPieceSize + 1;
+    if (count < pool.Size())
+    {
+        count = pool.Size();
+    }
+
+    std::vector<const char*> cuts(1, data);
+    for (size_t i = 1; i < count; i++)
+    {
+        const char* cut = data + length / count * i;
+        if (cut <= cuts.back())
+        {
+            continue;
+        }
+        cut = ReadLine(PreviousLine(data, cut + 1), data_end).next;
+        if (cut > cuts.back() && cut < data_end)
+        {
+            cuts.push_back(cut);
+        }
+    }
+    cuts.push_back(data_end);
+
+    std::vector<Piece> pieces(cuts.size() - 1);
+    pool.ParallelFor(pieces.size(), [&](size_t i)
+    {
+        ParsePiece(data, data_end, cuts[i], cuts[i + 1], pieces[i]);
+    });
+
+    /*
+     * join the pieces in order, turning line numbers into file line numbers
+     */
+    size_t tles = tles_.size();
+    for (size_t i = 0; i < pieces.size(); i++)
+    {
+        tles += pieces[i].tles.size();
+    }
+    tles_.reserve(tles);
+
+    size_t first_line = 1;
+    for (size_t i = 0; i < pieces.size(); i++)
+    {
+        Piece& piece = pieces[i];
+        tles_.insert(tles_.end(), piece.tles.begin(), piece.tles.end());
+        for (size_t j = 0; j < piece.errors.size(); j++)
+        {
+            piece.errors[j].line += first_line;
+            errors_.push_back(piece.errors[j]);
+        }
+        first_line += piece.lines;
+
+        /*
+         * release each piece as it is copied
+         */
+        std::vector<Tle>().swap(piece.tles);
+    }
+}
+
+/**
+ * Remove every tle and error from the catalog
+ */
+void TleCatalog::Clear()
+{
+    tles_.clear();
+    errors_.clear();
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2013 Daniel Warner <contact@danrw.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TLECATALOG_H_
+#define TLECATALOG_H_
+
+#include "Tle.h"
+#include "ThreadPool.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A set of tles loaded in bulk from an element file.
+ *
+ * Files may hold two line element sets, three line sets with a name line
+ * before each, or a mix of both. The file is mapped into memory and cut
+ * into pieces at line boundaries, the pieces are parsed across the
+ * threads of a ThreadPool and the results are kept in file order.
+ *
+ * A record that cannot be parsed does not stop the load. It is left out
+ * of Tles() and reported in Errors() with its line number instead.
+ */
+class TleCatalog
+{
+public:
+    /**
+     * @brief A record or line that could not be parsed.
+     */
+    struct Error
+    {
+        /*
+         * the line number of line one of the record, or of the line which
+         * is not part of one, from 1
+         */
+        size_t line;
+        std::string message;
+    };
+
+    TleCatalog()
+    {
+    }
+
+    virtual ~TleCatalog()
+    {
+    }
+
+    void Load(const std::string& filename, ThreadPool& pool);
+    void Parse(const char* data, const size_t length, ThreadPool& pool);
+    void Clear();
+
+    /**
+     * @returns the tles loaded, in file order
+     */
+    const std::vector<Tle>& Tles() const
+    {
+        return tles_;
+    }
+
+    /**
+     * @returns the records which failed to parse, in file order
+     */
+    const std::vector<Error>& Errors() const
+    {
+        return errors_;
+    }
+
+    /**
+     * @returns the number of tles loaded
+     */
+    size_t Size() const
+    {
+        return tles_.size();
+    }
+
+private:
+    std::vector<Tle> tles_;
+    std::vector<Error> errors_;
+};
+
+#endif
@@ -17,24 +17,390 @@
 
 #include <Tle.h>
 #include <SGP4.h>
+#include <SGP4Batch.h>
+#include <PropagatorFile.h>
+#include <PassPredictor.h>
+#include <ConjunctionScreener.h>
+#include <ThreadPool.h>
 #include <Observer.h>
 #include <CoordGeodetic.h>
 #include <CoordTopocentric.h>
 
+#include <algorithm>
 #include <list>
 #include <string>
 #include <iomanip>
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <cmath>
+#include <cstdio>
 #include <cstdlib>
 
+/*
+ * how far the other propagation paths may be from FindPosition(), in
+ * kilometers and kilometers per second. The vectorised paths match to
+ * the digits printed
+ */
+static const double kPositionTolerance = 1e-8;
+static const double kVelocityTolerance = 1e-9;
+/*
+ * the single precision paths, from the accuracy documented for
+ * SGP4::TryFindPositions() and Eci::ToGeodetic(), in kilometers,
+ * kilometers per second and radians
+ */
+static const double kFloatPositionTolerance = 4e-3;
+static const double kFloatVelocityTolerance = 5e-6;
+static const double kFloatLatitudeTolerance = 1.5e-7;
+static const double kFloatLongitudeTolerance = 4e-7;
+static const double kFloatAltitudeTolerance = 2.5e-3;
+/*
+ * relative rounding of float, and the altitude in kilometers below which
+ * the geodetic conversion is checked
+ */
+static const double kFloatRounding = 6e-8;
+static const double kLowEarthOrbit = 2000.0;
+/*
+ * the batched double precision geodetic conversion, from the accuracy
+ * documented for Eci::ToGeodetic() in radians and kilometers, and the
+ * altitude in kilometers and latitude in radians within which it holds
+ */
+static const double kGeodeticLatitudeTolerance = 1e-12;
+static const double kGeodeticLongitudeTolerance = 2e-15;
+static const double kGeodeticAltitudeTolerance = 2e-10;
+static const double kGeostationaryOrbit = 35786.0;
+static const double kGeodeticLatitudeLimit = 80.0 * kPI / 180.0;
+
+static int failures = 0;
+
+/*
+ * report a result of another path which differs from FindPosition()
+ */
+void Fail(const Tle& tle, const char* check, double tsince)
+{
+    std::cerr << std::setprecision(8) << std::fixed << tle.NoradNumber()
+        << " " << check << " differs at " << tsince << std::endl;
+    failures++;
+}
+
+/*
+ * the largest difference of the components of a and b
+ */
+double Difference(const Vector& a, double x, double y, double z)
+{
+    return std::max(fabs(a.x - x), std::max(fabs(a.y - y), fabs(a.z - z)));
+}
+
+/*
+ * whether two results are the same to the last bit
+ */
+bool Identical(const Eci& a, const Eci& b)
+{
+    const Vector pa = a.Position();
+    const Vector pb = b.Position();
+    const Vector va = a.Velocity();
+    const Vector vb = b.Velocity();
+    return pa.x == pb.x && pa.y == pb.y && pa.z == pb.z
+        && va.x == vb.x && va.y == vb.y && va.z == vb.z;
+}
+
+/*
+ * a one satellite SGP4Batch, which propagates to a date, against
+ * FindPosition() at the same date
+ */
+void CheckBatch(
+        const Tle& tle,
+        const std::vector<double>& times,
+        const std::vector<Eci>& results)
+{
+    SGP4 model(tle);
+    SGP4Batch batch;
+    batch.Add(model);
+
+    for (size_t i = 0; i < times.size(); i++)
+    {
+        const DateTime dt = results[i].GetDateTime();
+        double p[3];
+        double v[3];
+        SGP4::Status status;
+        batch.FindPositions(dt, p, v, &status);
+        const Eci eci = model.FindPosition(dt);
+        if (status != SGP4::kOk
+                || Difference(eci.Position(), p[0], p[1], p[2])
+                > kPositionTolerance
+                || Difference(eci.Velocity(), v[0], v[1], v[2])
+                > kVelocityTolerance)
+        {
+            Fail(tle, "SGP4Batch", times[i]);
+        }
+    }
+}
+
+/*
+ * SGP4::FindPositions(), which evaluates near earth satellites with the
+ * vectorised kernels, against FindPosition()
+ */
+void CheckFindPositions(
+        const Tle& tle,
+        const std::vector<double>& times,
+        const std::vector<Eci>& results)
+{
+    const size_t count = times.size();
+    SGP4 model(tle);
+    std::vector<double> position(3 * count);
+    std::vector<double> velocity(3 * count);
+
+    try
+    {
+        model.FindPositions(&times[0], count, &position[0], &velocity[0]);
+    }
+    catch (std::exception&)
+    {
+        Fail(tle, "FindPositions", times[0]);
+        return;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (Difference(results[i].Position(), position[3 * i],
+                    position[3 * i + 1], position[3 * i + 2])
+                > kPositionTolerance
+                || Difference(results[i].Velocity(), velocity[3 * i],
+                    velocity[3 * i + 1], velocity[3 * i + 2])
+                > kVelocityTolerance)
+        {
+            Fail(tle, "FindPositions", times[i]);
+        }
+    }
+}
+
+/*
+ * integrator checkpoints, visited out of order and thinned, against
+ * integrating from epoch
+ */
+void CheckCheckpoints(
+        const Tle& tle,
+        const std::vector<double>& times,
+        const std::vector<Eci>& results)
+{
+    SGP4 model(tle);
+    model.SetIntegratorCheckpoints(4);
+
+    for (size_t i = times.size(); i > 0; i--)
+    {
+        const Eci eci = model.FindPosition(times[i - 1]);
+        if (!Identical(eci, results[i - 1]))
+        {
+            Fail(tle, "SetIntegratorCheckpoints", times[i - 1]);
+        }
+    }
+}
+
+/*
+ * a model written to a PropagatorFile and restored, against the model
+ * built from the tle
+ */
+void CheckPropagatorFile(
+        const Tle& tle,
+        const std::vector<double>& times,
+        const std::vector<Eci>& results)
+{
+    const char* file_name = "runtest.prop";
+
+    PropagatorFile::Write(file_name, std::vector<Tle>(1, tle));
+    {
+        PropagatorFile file(file_name);
+        const SGP4 model = file.Model(0);
+
+        for (size_t i = 0; i < times.size(); i++)
+        {
+            const Eci eci = model.FindPosition(times[i]);
+            if (file.NoradNumber(0) != tle.NoradNumber()
+                    || !Identical(eci, results[i]))
+            {
+                Fail(tle, "PropagatorFile", times[i]);
+            }
+        }
+    }
+
+    /*
+     * a file claiming another gravity model is refused
+     */
+    {
+        std::fstream file(file_name,
+                std::ios::in | std::ios::out | std::ios::binary);
+        const char id[4] = {static_cast<char>(Wgs84::kId), 0, 0, 0};
+        file.seekp(12);
+        file.write(id, sizeof(id));
+    }
+    try
+    {
+        PropagatorFile file(file_name);
+        Fail(tle, "PropagatorFile gravity model", 0.0);
+    }
+    catch (SatelliteException&)
+    {
+    }
+    std::remove(file_name);
+}
+
+/*
+ * another gravity model, which propagates wherever Wgs72 does but to
+ * other positions
+ */
+template <typename Gravity>
+void CheckGravity(
+        const Tle& tle,
+        const std::vector<double>& times,
+        const std::vector<Eci>& results,
+        const char* check)
+{
+    size_t i = 0;
+    try
+    {
+        const SGP4Model<Gravity> model(tle);
+        for (; i < times.size(); i++)
+        {
+            if (Identical(model.FindPosition(times[i]), results[i]))
+            {
+                Fail(tle, check, times[i]);
+            }
+        }
+    }
+    catch (SatelliteException&)
+    {
+        Fail(tle, check, times[i]);
+    }
+    catch (DecayedException&)
+    {
+        Fail(tle, check, times[i]);
+    }
+}
+
+/*
+ * the single precision propagation and geodetic conversion, against
+ * double precision, and the batched geodetic conversion of the same
+ * positions against ToGeodetic()
+ */
+void CheckFloat(
+        const Tle& tle,
+        const std::vector<double>& times,
+        const std::vector<Eci>& results)
+{
+    const size_t count = times.size();
+    SGP4 model(tle);
+    std::vector<float> position(3 * count);
+    std::vector<float> velocity(3 * count);
+    std::vector<SGP4::Status> status(count);
+
+    model.TryFindPositions(&times[0], count, &position[0], &velocity[0],
+            &status[0]);
+
+    /*
+     * the geodetic conversion of the positions rounded to float
+     */
+    std::vector<float> rounded(3 * count);
+    std::vector<double> gmst(count);
+    std::vector<float> geodetic(3 * count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const Vector pos = results[i].Position();
+        rounded[3 * i] = static_cast<float>(pos.x);
+        rounded[3 * i + 1] = static_cast<float>(pos.y);
+        rounded[3 * i + 2] = static_cast<float>(pos.z);
+        gmst[i] = results[i].GetDateTime().ToGreenwichSiderealTime();
+    }
+    Eci::ToGeodetic(&rounded[0], &gmst[0], count, &geodetic[0]);
+
+    std::vector<double> exact(3 * count);
+    std::vector<double> batched(3 * count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const Vector pos = results[i].Position();
+        exact[3 * i] = pos.x;
+        exact[3 * i + 1] = pos.y;
+        exact[3 * i + 2] = pos.z;
+    }
+    Eci::ToGeodetic(&exact[0], &gmst[0], count, &batched[0]);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const Vector pos = results[i].Position();
+        const Vector vel = results[i].Velocity();
+
+        /*
+         * deep space satellites are propagated in double precision and
+         * rounded
+         */
+        double position_tolerance = kFloatPositionTolerance;
+        double velocity_tolerance = kFloatVelocityTolerance;
+        if (model.UsesDeepSpace())
+        {
+            position_tolerance = kFloatRounding * pos.Magnitude();
+            velocity_tolerance = kFloatRounding * vel.Magnitude();
+        }
+
+        if (status[i] != SGP4::kOk
+                || Difference(pos, position[3 * i], position[3 * i + 1],
+                    position[3 * i + 2]) > position_tolerance
+                || Difference(vel, velocity[3 * i], velocity[3 * i + 1],
+                    velocity[3 * i + 2]) > velocity_tolerance)
+        {
+            Fail(tle, "TryFindPositions", times[i]);
+        }
+
+        const CoordGeodetic geo = results[i].ToGeodetic();
+
+        /*
+         * the accuracy of the batch holds from the surface out to
+         * geostationary orbit, the altitude away from the poles
+         */
+        if (geo.altitude >= 0.0 && geo.altitude <= kGeostationaryOrbit)
+        {
+            const double dlat = fabs(geo.latitude - batched[3 * i]);
+            const double dlon = fabs(Util::WrapNegPosPI(
+                        geo.longitude - batched[3 * i + 1]));
+            const double dalt = fabs(geo.altitude - batched[3 * i + 2]);
+            if (dlat > kGeodeticLatitudeTolerance
+                    || dlon > kGeodeticLongitudeTolerance
+                    || (fabs(geo.latitude) <= kGeodeticLatitudeLimit
+                        && dalt > kGeodeticAltitudeTolerance))
+            {
+                Fail(tle, "Eci::ToGeodetic batch", times[i]);
+            }
+        }
+
+        /*
+         * the accuracy of single precision holds for low earth orbits
+         */
+        if (geo.altitude > kLowEarthOrbit)
+        {
+            continue;
+        }
+        const double dlat = fabs(geo.latitude - geodetic[3 * i]);
+        const double dlon = fabs(Util::WrapNegPosPI(
+                    geo.longitude - geodetic[3 * i + 1]));
+        const double dalt = fabs(geo.altitude - geodetic[3 * i + 2]);
+        if (dlat > kFloatLatitudeTolerance
+                || dlon > kFloatLongitudeTolerance
+                || dalt > kFloatAltitudeTolerance)
+        {
+            Fail(tle, "Eci::ToGeodetic", times[i]);
+        }
+    }
+}
+
 void RunTle(Tle tle, double start, double end, double inc)
 {
     double current = start;
     SGP4 model(tle);
     bool running = true;
     bool first_run = true;
+    /*
+     * the results, to check the other propagation paths against
+     */
+    std::vector<double> times;
+    std::vector<Eci> results;
 
     std::cout << std::setprecision(0) << tle.NoradNumber() << " xx"
         << std::endl;
@@ -66,6 +432,9 @@ void RunTle(Tle tle, double start, double end, double inc)
             Eci eci = model.FindPosition(tsince);
             position = eci.Position();
             velocity = eci.Velocity();
+
+            times.push_back(tsince);
+            results.push_back(eci);
         }
         catch (SatelliteException& e)
         {
@@ -126,6 +495,203 @@ void RunTle(Tle tle, double start, double end, double inc)
         }
         first_run = false;
     }
+
+    if (!times.empty())
+    {
+        CheckBatch(tle, times, results);
+        CheckFindPositions(tle, times, results);
+        CheckCheckpoints(tle, times, results);
+        CheckPropagatorFile(tle, times, results);
+        CheckGravity<Wgs72Old>(tle, times, results, "SGP4Model<Wgs72Old>");
+        CheckGravity<Wgs84>(tle, times, results, "SGP4Model<Wgs84>");
+        CheckFloat(tle, times, results);
+    }
+}
+
+/*
+ * PassPredictor against stepping a second at a time, for a deep space
+ * satellite whose orbit has turned far from its inclination at epoch,
+ * over a station at a latitude it only reaches years after epoch
+ */
+void CheckPasses()
+{
+    const Tle tle("23333",
+            "1 23333U 94071A   94305.49999999 -.00172956  26967-3  "
+            "10000-3 0    15",
+            "2 23333  28.7490   2.3720 9728298  30.4360   1.3500  "
+            "0.07309491    70");
+    const CoordGeodetic station(78.2, 15.4, 0.5);
+    const double mask = 45.0 * kPI / 180.0;
+    const DateTime start(2012, 10, 20);
+    const int duration = 86400;
+
+    ThreadPool pool(1);
+    PassPredictor predictor(std::vector<Tle>(1, tle),
+            std::vector<CoordGeodetic>(1, station), pool);
+    const std::vector<Pass> passes = predictor.FindPasses(start,
+            start.AddSeconds(duration), mask);
+
+    SGP4 model(tle);
+    Observer observer(station);
+    std::vector<double> aos;
+    std::vector<double> los;
+    bool up = false;
+    for (int t = 0; t <= duration; t++)
+    {
+        const Eci eci = model.FindPosition(start.AddSeconds(t));
+        const bool next_up = observer.GetLookAngle(eci).elevation >= mask;
+        if (next_up && !up)
+        {
+            aos.push_back(t);
+        }
+        else if (!next_up && up)
+        {
+            los.push_back(t - 1);
+        }
+        up = next_up;
+    }
+    if (up)
+    {
+        los.push_back(duration);
+    }
+
+    /*
+     * the roots lie within the second before acquisition and after loss
+     * of signal found by stepping
+     */
+    if (passes.size() != aos.size())
+    {
+        Fail(tle, "PassPredictor", 0.0);
+        return;
+    }
+    for (size_t i = 0; i < passes.size(); i++)
+    {
+        const double pass_aos = (passes[i].aos - start).TotalSeconds();
+        const double pass_los = (passes[i].los - start).TotalSeconds();
+        if (pass_aos < aos[i] - 1.0 || pass_aos > aos[i]
+                || pass_los < los[i] || pass_los > los[i] + 1.0)
+        {
+            Fail(tle, "PassPredictor", aos[i]);
+        }
+    }
+}
+
+/*
+ * ConjunctionScreener against the pair distances stepping a second at a
+ * time, for near earth and deep space satellites of the verification set
+ * over two hours, with a threshold passing most of their approaches
+ */
+void CheckConjunctions()
+{
+    static const char* const kLines[][2] = {
+        {"1 06251U 62025E   06176.82412014  .00008885  00000-0  "
+            "12808-3 0  3985",
+         "2 06251  58.0579  54.0425 0030035 139.1568 221.1854 "
+            "15.56387291  6774"},
+        {"1 28057U 03049A   06177.78615833  .00000060  00000-0  "
+            "35940-4 0  1836",
+         "2 28057  98.4283 247.6961 0000884  88.1964 271.9322 "
+            "14.35478080140550"},
+        {"1 29238U 06022G   06177.28732010  .00766286  10823-4  "
+            "13334-2 0   101",
+         "2 29238  51.5595 213.7903 0202579  95.2503 267.9010 "
+            "15.73823839  1061"},
+        {"1 21897U 92011A   06176.02341244 -.00001273  00000-0 "
+            "-13525-3 0  3044",
+         "2 21897  62.1749 198.0096 7421690 253.0462  20.1561  "
+            "2.01269994104880"},
+        {"1 23177U 94040C   06175.45752052  .00000386  00000-0  "
+            "76590-3 0    95",
+         "2 23177   7.0496 179.8238 7258491 296.0482   8.3061  "
+            "2.25906668 97438"}
+    };
+    const size_t count = sizeof(kLines) / sizeof(kLines[0]);
+    const DateTime start(2006, 6, 26);
+    const int duration = 7200;
+    const double threshold = 10000.0;
+
+    std::vector<Tle> tles;
+    for (size_t i = 0; i < count; i++)
+    {
+        tles.push_back(Tle("Test", kLines[i][0], kLines[i][1]));
+    }
+
+    ThreadPool pool(2);
+    ConjunctionScreener screener(tles, pool);
+    const std::vector<Conjunction> conjunctions = screener.Screen(start,
+            start.AddSeconds(duration), threshold);
+
+    std::vector<std::vector<Vector> > positions(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        SGP4 model(tles[i]);
+        for (int t = 0; t <= duration; t++)
+        {
+            positions[i].push_back(
+                    model.FindPosition(start.AddSeconds(t)).Position());
+        }
+    }
+
+    /*
+     * each minimum of the distance of a pair, at a step or an end of the
+     * window, within the threshold has a conjunction of the pair within
+     * the second either side of it and no further apart, and every
+     * conjunction has such a minimum
+     */
+    size_t matched = 0;
+    for (size_t a = 0; a < count; a++)
+    {
+        for (size_t b = a + 1; b < count; b++)
+        {
+            std::vector<double> distance(positions[a].size());
+            for (size_t t = 0; t < distance.size(); t++)
+            {
+                distance[t] = (positions[b][t] - positions[a][t]).Magnitude();
+            }
+
+            for (size_t t = 0; t < distance.size(); t++)
+            {
+                if ((t > 0 && distance[t] >= distance[t - 1])
+                        || (t + 1 < distance.size()
+                            && distance[t] > distance[t + 1]))
+                {
+                    continue;
+                }
+
+                const Conjunction* conjunction = NULL;
+                for (size_t c = 0; c < conjunctions.size(); c++)
+                {
+                    const double tca
+                        = (conjunctions[c].tca - start).TotalSeconds();
+                    if (conjunctions[c].first == a
+                            && conjunctions[c].second == b
+                            && fabs(tca - static_cast<double>(t)) <= 1.0)
+                    {
+                        conjunction = &conjunctions[c];
+                    }
+                }
+
+                if (conjunction)
+                {
+                    matched++;
+                    if (conjunction->distance > distance[t] + 1e-6)
+                    {
+                        Fail(tles[a], "ConjunctionScreener",
+                                static_cast<double>(t));
+                    }
+                }
+                else if (distance[t] <= threshold)
+                {
+                    Fail(tles[a], "ConjunctionScreener",
+                            static_cast<double>(t));
+                }
+            }
+        }
+    }
+    if (matched != conjunctions.size())
+    {
+        Fail(tles[0], "ConjunctionScreener", 0.0);
+    }
 }
 
 void tokenize(const std::string& str, std::vector<std::string>& tokens)
@@ -276,6 +842,15 @@ int main()
     const char* file_name = "SGP4-VER.TLE";
 
     RunTest(file_name);
+    CheckPasses();
+    CheckConjunctions();
+
+    if (failures > 0)
+    {
+        std::cerr << failures << " results of other paths differ"
+            << std::endl;
+        return EXIT_FAILURE;
+    }
 
-    return 1;
+    return EXIT_SUCCESS;
 }